@@ -0,0 +1,268 @@
+// This file scans many small documents at once, for scan_batch() in trebuchet.h.
+//
+// scan_utf8() is fast on big inputs, because it looks at 16 bytes of one input at a time. But a document
+// of 20 bytes fills one vector and a quarter of another, and then there's the cost of setting up and
+// finishing each scan. With millions of documents like that, most of the work is overhead.
+//
+// So here, we turn the problem sideways: each of the 16 bytes in a vector comes from a different document.
+// One vector operation then moves 16 documents forward by one byte each, and every byte is useful work.
+
+// stdint.h used for SIZE_MAX
+#include <stdint.h>
+// string.h used for memcpy()
+#include <string.h>
+// limits.h used for INT_MAX
+#include <limits.h>
+
+#include "trebuchet.h"
+
+// The same check as in trebuchet.c, which explains it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Scan one document with scan_input(), and copy what the caller needs into 'result'.
+static void scan_one(const scan_state_t *options, const aoc_span_t *document, scan_result_t *result)
+{
+    if (compiled_detect((const unsigned char *)document->data, document->length))
+    {
+        *result = (scan_result_t){StatusCompiled, 0, 0, 0, 0}; // Only scan_compiled() reads these.
+        return;
+    }
+    scan_state_t state;
+    scan_init(&state);
+    if (options != NULL)
+    {
+        state.strict = options->strict;
+        state.maxLineLength = options->maxLineLength;
+        state.words = options->words;
+    }
+    result->status = scan_input(&state, (const unsigned char *)document->data, document->length);
+    result->sum = state.sum;
+    result->overflowValue = state.overflowValue;
+    result->lines = state.lines;
+    result->errorOffset = state.errorOffset;
+}
+
+#ifdef HAVE_SSE2
+#define LANES 16
+
+/*
+    Transpose a 16 x 16 block of bytes: afterwards, byte j of rows[k] is what was byte k of rows[j].
+
+    _mm_unpacklo_epi8(a, b) interleaves the low halves of a and b: a0 b0 a1 b1 ... a7 b7, and
+    _mm_unpackhi_epi8 does the same with the high halves. Interleaving row i with row i + 8, for every i,
+    is a "perfect shuffle" of the whole block. Four of those (since 2^4 = 16) put every byte where it belongs.
+
+    See: https://en.wikipedia.org/wiki/Transpose
+    See: https://en.wikipedia.org/wiki/Faro_shuffle#Perfect_shuffles_in_computing
+*/
+static inline void transpose(__m128i rows[LANES])
+{
+    __m128i shuffled[LANES];
+    for (int round = 0; round < 4; round++)
+    {
+        for (int i = 0; i < LANES / 2; i++)
+        {
+            shuffled[2 * i] = _mm_unpacklo_epi8(rows[i], rows[i + LANES / 2]);
+            shuffled[2 * i + 1] = _mm_unpackhi_epi8(rows[i], rows[i + LANES / 2]);
+        }
+        memcpy(rows, shuffled, sizeof shuffled);
+    }
+}
+
+/*
+    Everything we know about the line that each lane's document is on, one byte per lane.
+    It's the vector version of 'digitsSeen' and 'calibration' in scan_state_t.
+*/
+typedef struct LANE_STATE
+{
+    __m128i first;    // The line's first digit (0-9).
+    __m128i last;     // The line's last digit so far.
+    __m128i seen;     // 0xFF if the line has had a digit, 0x00 if not.
+    __m128i nonAscii; // Every byte of the document OR-ed together: the top bit says if there were any non-ASCII bytes.
+    __m128i sumLow;   // The lane's sum so far, as 16-bit numbers: lanes 0-7...
+    __m128i sumHigh;  // ...and lanes 8-15.
+    __m128i newlines; // How many newlines the lane has had, since the last flush().
+} lane_state_t;
+
+/*
+    Move all 16 lanes forward by one byte: 'bytes' holds the next byte of each lane's document.
+
+    There are no branches here. Every lane does all of the work, and masks (0xFF or 0x00 per lane) decide
+    which results it keeps, by AND-ing them with the new value, and AND-NOT-ing them with the old one.
+
+    See: https://en.wikipedia.org/wiki/Predication_(computer_architecture)
+*/
+static inline void step(lane_state_t *lanes, __m128i bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i digit = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)), zero); // As in scan_utf8().
+    __m128i isNewline = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+
+    __m128i isFirst = _mm_andnot_si128(lanes->seen, isDigit); // A digit, on a line that didn't have one yet.
+    lanes->first = _mm_or_si128(_mm_and_si128(isFirst, digit), _mm_andnot_si128(isFirst, lanes->first));
+    lanes->last = _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, lanes->last));
+    lanes->seen = _mm_or_si128(lanes->seen, isDigit);
+    lanes->nonAscii = _mm_or_si128(lanes->nonAscii, bytes);
+
+    /*
+        Lines that end here add first * 10 + last to their sum. SSE2 can't multiply bytes, but
+        10 * first is 8 * first + 2 * first, and doubling is adding a number to itself. The
+        result is at most 99, so it still fits in a byte. Then it's widened to 16 bits to add it up.
+    */
+    __m128i twice = _mm_add_epi8(lanes->first, lanes->first);
+    __m128i eight = _mm_add_epi8(_mm_add_epi8(twice, twice), _mm_add_epi8(twice, twice));
+    __m128i value = _mm_add_epi8(_mm_add_epi8(eight, twice), lanes->last);
+    value = _mm_and_si128(value, _mm_and_si128(isNewline, lanes->seen));
+    lanes->sumLow = _mm_add_epi16(lanes->sumLow, _mm_unpacklo_epi8(value, zero));
+    lanes->sumHigh = _mm_add_epi16(lanes->sumHigh, _mm_unpackhi_epi8(value, zero));
+    lanes->seen = _mm_andnot_si128(isNewline, lanes->seen); // A new line hasn't had a digit yet.
+    lanes->newlines = _mm_sub_epi8(lanes->newlines, isNewline); // 0xFF is -1, so subtracting it adds 1.
+}
+
+/*
+    The newline counts are bytes, which can count 255 lines (one per step, at most), and the 16-bit sums can
+    take 65535 / 99 = 661. So every 15 blocks of 16 steps (240 lines, plus one for a document's end), they're
+    added into 64-bit totals and start again from zero.
+*/
+#define FLUSH_BLOCKS 15
+
+static void flush(lane_state_t *lanes, unsigned long long totals[LANES], unsigned long long lines[LANES])
+{
+    unsigned short sums[LANES];
+    unsigned char newlines[LANES];
+    _mm_storeu_si128((__m128i *)sums, lanes->sumLow);
+    _mm_storeu_si128((__m128i *)(sums + LANES / 2), lanes->sumHigh);
+    _mm_storeu_si128((__m128i *)newlines, lanes->newlines);
+    for (int j = 0; j < LANES; j++)
+    {
+        totals[j] += sums[j];
+        lines[j] += newlines[j];
+    }
+    lanes->sumLow = lanes->sumHigh = lanes->newlines = _mm_setzero_si128();
+}
+#endif
+
+void scan_batch(const scan_state_t *options, const aoc_span_t *documents, size_t count, scan_result_t *results)
+{
+    size_t next = 0; // The next document that doesn't have a lane yet.
+
+#ifdef HAVE_SSE2
+    /*
+        Only plain digit counting works sideways. Strict mode and spelled-out words need the full scanner,
+        and so does any document with non-ASCII bytes (including a BOM), which we find out at its end.
+    */
+    bool sideways = options == NULL || (!options->strict && options->words == NULL);
+    size_t documentOf[LANES], position[LANES]; // Which document each lane is on (SIZE_MAX for none), and where.
+    unsigned long long totals[LANES] = {0}, lines[LANES] = {0};
+    lane_state_t lanes = {0};
+    unsigned blocks = 0, active = 0;
+
+    for (int j = 0; j < LANES; j++)
+        documentOf[j] = SIZE_MAX;
+    while (sideways)
+    {
+        // Give every idle lane a document. An empty one has nothing to scan, so it's done on the spot.
+        for (int j = 0; j < LANES; j++)
+            while (documentOf[j] == SIZE_MAX && next < count)
+            {
+                if (documents[next].length == 0)
+                {
+                    results[next++] = (scan_result_t){StatusOk, 0, 0, 0, 0};
+                    continue;
+                }
+                if (compiled_detect((const unsigned char *)documents[next].data, documents[next].length))
+                {
+                    scan_one(options, &documents[next], &results[next]);
+                    next++;
+                    continue;
+                }
+                documentOf[j] = next++;
+                position[j] = 0;
+                active++;
+            }
+        if (active == 0)
+            break;
+
+        /*
+            Load 16 bytes from each lane's document, then transpose, so that rows[k] holds byte k of every
+            lane. A document with fewer than 16 bytes left is copied into a buffer of zeros first, so we
+            never read past its end. Zero bytes aren't digits or newlines, so they don't change anything.
+        */
+        __m128i rows[LANES];
+        unsigned finishing = 0; // Bit j is set if lane j's document ends in this block.
+        for (int j = 0; j < LANES; j++)
+        {
+            if (documentOf[j] == SIZE_MAX)
+            {
+                rows[j] = _mm_setzero_si128();
+                continue;
+            }
+            const aoc_span_t *document = &documents[documentOf[j]];
+            size_t left = document->length - position[j];
+            if (left > 16)
+                rows[j] = _mm_loadu_si128((const __m128i *)(document->data + position[j]));
+            else
+            {
+                unsigned char tail[16] = {0};
+                memcpy(tail, document->data + position[j], left);
+                rows[j] = _mm_loadu_si128((const __m128i *)tail);
+                finishing |= 1u << j;
+            }
+            position[j] += 16;
+        }
+        transpose(rows);
+        for (int k = 0; k < LANES; k++)
+            step(&lanes, rows[k]);
+        if (++blocks == FLUSH_BLOCKS)
+        {
+            flush(&lanes, totals, lines);
+            blocks = 0;
+        }
+        if (finishing == 0)
+            continue;
+
+        // Some documents ended. Each one finishes its last line, as if it ended in a newline.
+        unsigned char ends[LANES] = {0};
+        for (int j = 0; j < LANES; j++)
+            ends[j] = (finishing >> j & 1) ? '\n' : '\0';
+        step(&lanes, _mm_loadu_si128((const __m128i *)ends));
+        flush(&lanes, totals, lines);
+
+        // Take the finished lanes' results out of the vectors, and reset those lanes for their next document.
+        unsigned char seen[LANES], nonAscii[LANES];
+        _mm_storeu_si128((__m128i *)seen, lanes.seen);
+        _mm_storeu_si128((__m128i *)nonAscii, lanes.nonAscii);
+        for (int j = 0; j < LANES; j++)
+        {
+            if (!(finishing >> j & 1))
+                continue;
+            size_t d = documentOf[j];
+            if ((nonAscii[j] & 0x80) || totals[j] > INT_MAX) // The full scanner handles (and reports) these properly.
+                scan_one(options, &documents[d], &results[d]);
+            else
+            {
+                /*
+                    The newline added above stands for the end of the last line, which scan_finish() counts. If
+                    the document ended with a newline already, there's no last line, and it doesn't count.
+                */
+                const aoc_span_t *document = &documents[d];
+                bool endsInNewline = ((const unsigned char *)document->data)[document->length - 1] == '\n';
+                results[d] = (scan_result_t){StatusOk, (int)totals[j], 0, lines[j] - endsInNewline, 0};
+            }
+            totals[j] = lines[j] = 0;
+            seen[j] = nonAscii[j] = 0;
+            documentOf[j] = SIZE_MAX;
+            active--;
+        }
+        lanes.seen = _mm_loadu_si128((const __m128i *)seen);
+        lanes.nonAscii = _mm_loadu_si128((const __m128i *)nonAscii);
+    }
+#endif
+
+    for (; next < count; next++) // Everything that can't go sideways (or everything, without SSE2).
+        scan_one(options, &documents[next], &results[next]);
+}
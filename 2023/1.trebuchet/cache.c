@@ -0,0 +1,313 @@
+// This file cuts an input into chunks, and remembers each chunk's result between runs, for cache.h and
+// scan_cached() in trebuchet.h.
+
+/*
+    Where to cut.
+
+    Cutting every 64 KiB would be simplest, but one extra byte in the middle of the input would move every
+    cut after it, so no chunk after the edit would be the same as last time. Instead, the bytes decide where
+    the cuts go ("content-defined chunking"). An edit only moves the cuts near it. Past that, the same bytes
+    give the same cuts, and the same chunks as last time.
+
+    The usual way is a "rolling hash" of the last 64 bytes or so, worked out at every byte, with a cut
+    wherever it happens to end in enough 0 bits. But chunks have to hold whole lines anyway, so they can be
+    scanned on their own (like the pipeline's blocks, see parallel.c), and the only places worth cutting are
+    just after a newline. So we only hash there: the 8 bytes before each newline, with one multiplication,
+    and cut after the line if the top 11 bits are 0, which happens once in 2048 lines, on average. That's
+    about 64 KiB of the puzzle's lines. memchr() finds the newlines with SIMD instructions, and hashing one
+    spot in each line is less work than a rolling hash's few instructions for every byte: this takes about
+    half as long.
+
+    Chunks are at least 16 KiB (we don't look for cuts before then), and stop at the first newline after
+    256 KiB, so many lines that end the same way can't make a chunk huge.
+
+    See: https://en.wikipedia.org/wiki/Rolling_hash
+    See: https://www.usenix.org/conference/atc16/technical-sessions/presentation/xia (FastCDC, a rolling hash for this)
+*/
+
+/*
+    The cache file. Numbers are little-endian, like a compiled input's (see compiled.c).
+
+        bytes 0-7    89 'T' 'R' 'C' '\r' '\n' 1A '\n', the "magic number"
+        bytes 8-11   the format's version, 1
+        bytes 12-15  0, for now
+        bytes 16-23  how many entries there are
+        then         40 bytes for each entry: its hash, options, length and lines (8 bytes each), then
+                     its sum (4 bytes), and 4 bytes of 0
+*/
+
+// limits.h used for INT_MAX
+#include <limits.h>
+// stdint.h used for SIZE_MAX
+#include <stdint.h>
+// stdlib.h used for memory allocation, qsort() and bsearch()
+#include <stdlib.h>
+// string.h used for memchr(), memcmp() and memcpy()
+#include <string.h>
+
+#include "trebuchet.h"
+
+#define MIN_CHUNK (16 << 10)
+#define MAX_CHUNK (256 << 10)
+#define CUT_SHIFT 53 // Cut where the top 64 - 53 = 11 bits of the hash are 0: once in 2048 lines.
+
+#define HEADER_SIZE 24
+#define ENTRY_SIZE 40
+#define VERSION 1
+
+static const unsigned char Magic[8] = {0x89, 'T', 'R', 'C', '\r', '\n', 0x1A, '\n'};
+
+// Find where the chunk that starts at 'start' ends, as above.
+static size_t chunk_end(const unsigned char *data, size_t start, size_t length)
+{
+    if (length - start <= MIN_CHUNK)
+        return length;
+    const unsigned char *next = data + start + MIN_CHUNK, *end = data + length;
+    const unsigned char *limit = length - start <= MAX_CHUNK ? end : data + start + MAX_CHUNK;
+    for (;;)
+    {
+        const unsigned char *newline = memchr(next, '\n', (size_t)(end - next));
+        if (newline == NULL)
+            return length;
+        unsigned long long last; // The line's last 8 bytes. There are always 8, since we're MIN_CHUNK in.
+        memcpy(&last, newline - 8, 8);
+        next = newline + 1;
+        if ((last * 0x9E3779B97F4A7C15ull) >> CUT_SHIFT == 0 || next >= limit)
+            return (size_t)(next - data);
+    }
+}
+
+/*
+    Hash all of a chunk's bytes, to recognise it next time. Each step is like one round of MurmurHash's
+    "finalizer": multiplying mixes the low bits into the high ones, and the shift mixes them back down. It
+    reads 32 bytes at a time into four separate hashes, combined at the end: one hash would have to wait
+    for each multiplication to finish before starting the next, but four can go at once. Two different
+    chunks of the same length have about a 1 in 2^64 chance of getting the same hash.
+
+    Reading 8 bytes with memcpy() is how to load a number from an address that may not be aligned. The
+    compiler turns it into a single instruction.
+
+    See: https://en.wikipedia.org/wiki/MurmurHash
+    See: https://en.wikipedia.org/wiki/Instruction-level_parallelism
+*/
+static unsigned long long chunk_hash(const unsigned char *data, size_t length)
+{
+    unsigned long long lanes[4] = {length, length ^ 1, length ^ 2, length ^ 3}, word;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32)
+        for (int lane = 0; lane < 4; lane++)
+        {
+            memcpy(&word, data + i + 8 * lane, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0xFF51AFD7ED558CCDull;
+            lanes[lane] ^= lanes[lane] >> 32;
+        }
+    unsigned long long hash = lanes[0] * 0x9E3779B97F4A7C15ull;
+    for (int lane = 1; lane < 4; lane++)
+        hash = (hash ^ lanes[lane]) * 0x9E3779B97F4A7C15ull;
+    for (; i < length; i += 8) // The rest, 8 bytes at a time, and the last few padded with 0s.
+    {
+        word = 0;
+        memcpy(&word, data + i, length - i < 8 ? length - i : 8);
+        hash = (hash ^ word) * 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 29;
+    }
+    return hash ^ (hash >> 32);
+}
+
+// Everything about the options that changes a chunk's result. 'maxLineLength' only matters in strict mode.
+static unsigned long long options_key(const scan_state_t *state)
+{
+    unsigned long long key = state->words != NULL ? 2 : 0;
+    if (state->strict)
+        key |= 1 | (unsigned long long)state->maxLineLength << 2;
+    return key;
+}
+
+// Order entries by hash, then options, then length, for qsort() and bsearch().
+static int compare_entries(const void *left, const void *right)
+{
+    const cache_entry_t *a = left, *b = right;
+    if (a->hash != b->hash)
+        return a->hash < b->hash ? -1 : 1;
+    if (a->options != b->options)
+        return a->options < b->options ? -1 : 1;
+    return a->length < b->length ? -1 : a->length > b->length;
+}
+
+const char *cache_load(chunk_cache_t *cache, const char *path)
+{
+    *cache = (chunk_cache_t){0};
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) // Nothing cached yet. (If it can't be read for another reason, saving will say so.)
+        return NULL;
+    (void)fclose(file);
+
+    aoc_input_t input;
+    const char *error = aoc_input_load(&input, path);
+    if (error != NULL)
+        return error;
+    // Not a cache: don't scribble over it when we save, in case it's something important, like the input.
+    if (input.length < HEADER_SIZE || memcmp(input.data, Magic, sizeof Magic) != 0)
+        error = "Not a cache file";
+    else if (aoc_get_le(input.data + 8, 4) != VERSION)
+        error = "Cache file from a different version of trebuchet";
+    else if (aoc_get_le(input.data + 16, 8) > (input.length - HEADER_SIZE) / ENTRY_SIZE)
+        error = "Damaged cache file";
+    if (error == NULL)
+    {
+        cache->oldCount = (size_t)aoc_get_le(input.data + 16, 8);
+        cache->old = malloc((cache->oldCount + 1) * sizeof *cache->old); // + 1: malloc(0) may return NULL.
+        if (cache->old == NULL)
+            error = "Out of memory";
+    }
+    for (size_t i = 0; error == NULL && i < cache->oldCount; i++)
+    {
+        const unsigned char *bytes = input.data + HEADER_SIZE + i * ENTRY_SIZE;
+        cache->old[i] = (cache_entry_t){aoc_get_le(bytes, 8), aoc_get_le(bytes + 8, 8), aoc_get_le(bytes + 16, 8),
+                                        aoc_get_le(bytes + 24, 8), (int)(unsigned)aoc_get_le(bytes + 32, 4)};
+    }
+    aoc_input_free(&input);
+    if (error != NULL)
+    {
+        cache_free(cache);
+        return error;
+    }
+    qsort(cache->old, cache->oldCount, sizeof *cache->old, compare_entries);
+    return NULL;
+}
+
+// Add an entry for this run's next chunk. Returns false if there's no memory.
+static bool record(chunk_cache_t *cache, const cache_entry_t *entry)
+{
+    if (cache->freshCount == cache->freshCapacity)
+    {
+        size_t capacity = cache->freshCapacity == 0 ? 256 : cache->freshCapacity * 2;
+        if (capacity > SIZE_MAX / sizeof *cache->fresh)
+            return false;
+        cache_entry_t *fresh = realloc(cache->fresh, capacity * sizeof *fresh);
+        if (fresh == NULL)
+            return false;
+        cache->fresh = fresh;
+        cache->freshCapacity = capacity;
+    }
+    cache->fresh[cache->freshCount++] = *entry;
+    return true;
+}
+
+// Store 'entry' in the file's format, at 'bytes'.
+static void put_entry(unsigned char *bytes, const cache_entry_t *entry)
+{
+    aoc_put_le(bytes, entry->hash, 8);
+    aoc_put_le(bytes + 8, entry->options, 8);
+    aoc_put_le(bytes + 16, entry->length, 8);
+    aoc_put_le(bytes + 24, entry->lines, 8);
+    aoc_put_le(bytes + 32, (unsigned)entry->sum, 4);
+    aoc_put_le(bytes + 36, 0, 4);
+}
+
+const char *cache_save(const chunk_cache_t *cache, const char *path)
+{
+    /*
+        Keep this run's chunks, which replace the ones from last time with the same options: the input they
+        came from is gone. Entries for other options (say, --spelled) stay, for the next run with those.
+    */
+    size_t count = cache->freshCount;
+    for (size_t i = 0; i < cache->oldCount; i++)
+        count += cache->old[i].options != cache->options;
+    if (count > (SIZE_MAX - HEADER_SIZE) / ENTRY_SIZE)
+        return "Out of memory";
+    unsigned char *bytes = calloc(HEADER_SIZE + count * ENTRY_SIZE, 1);
+    if (bytes == NULL)
+        return "Out of memory";
+    memcpy(bytes, Magic, sizeof Magic);
+    aoc_put_le(bytes + 8, VERSION, 4);
+    aoc_put_le(bytes + 16, count, 8);
+    unsigned char *next = bytes + HEADER_SIZE;
+    for (size_t i = 0; i < cache->freshCount; i++, next += ENTRY_SIZE)
+        put_entry(next, &cache->fresh[i]);
+    for (size_t i = 0; i < cache->oldCount; i++)
+        if (cache->old[i].options != cache->options)
+        {
+            put_entry(next, &cache->old[i]);
+            next += ENTRY_SIZE;
+        }
+    const char *error = aoc_file_replace(path, bytes, HEADER_SIZE + count * ENTRY_SIZE);
+    free(bytes);
+    return error;
+}
+
+void cache_free(chunk_cache_t *cache)
+{
+    free(cache->old);
+    free(cache->fresh);
+    cache->old = cache->fresh = NULL;
+    cache->oldCount = cache->freshCount = cache->freshCapacity = 0;
+}
+
+status_t scan_cached(scan_state_t *state, const unsigned char *data, size_t length, chunk_cache_t *cache)
+{
+    size_t bomLength;
+    if (detect_encoding(data, length, &bomLength) != EncodingUtf8) // Chunks are cut at '\n' bytes: UTF-8 only.
+        return scan_input(state, data, length);
+    cache->options = options_key(state);
+    state->offset = state->lineStart = bomLength;
+
+    for (size_t start = bomLength, end; start < length; start = end)
+    {
+        end = chunk_end(data, start, length);
+        cache_entry_t entry = {chunk_hash(data + start, end - start), cache->options, end - start, 0, 0};
+        const cache_entry_t *found =
+            cache->oldCount == 0 ? NULL : bsearch(&entry, cache->old, cache->oldCount, sizeof entry, compare_entries);
+        bool overflows = false; // Whether the chunk overflows even from a sum of 0, which entry.sum can't show.
+        if (found != NULL)
+        {
+            entry = *found;
+            cache->hits++;
+            cache->hitBytes += entry.length;
+        }
+        else
+        {
+            // Scan the chunk by itself, from a sum of 0, for a result that doesn't depend on the chunks before it.
+            scan_state_t chunk;
+            scan_init(&chunk);
+            chunk.strict = state->strict;
+            chunk.maxLineLength = state->maxLineLength;
+            chunk.words = state->words;
+            chunk.offset = chunk.lineStart = start;
+            status_t status = scan_utf8(&chunk, data + start, end - start);
+            if (status == StatusOk && end == length)
+                status = scan_finish(&chunk); // The last chunk may not end in a newline.
+            /*
+                An error in the chunk is only the answer if the sum doesn't overflow first. chunk.sum is what came
+                before the error, so if adding it overflows, the overflow is the answer: see below.
+            */
+            overflows = status == StatusOverflow;
+            if (status != StatusOk && !overflows && chunk.sum <= INT_MAX - state->sum)
+            {
+                state->lines += chunk.lines;
+                state->errorOffset = chunk.errorOffset; // It already counts from the start of the input, like scan_input()'s.
+                state->overflowValue = chunk.overflowValue;
+                return status;
+            }
+            entry.lines = chunk.lines;
+            entry.sum = chunk.sum;
+            cache->misses++;
+        }
+        cache->bytes += entry.length;
+
+        if (overflows || entry.sum > INT_MAX - state->sum)
+        {
+            // The sum overflows somewhere in this chunk. Scan it again from the sum so far, to say exactly where.
+            status_t status = scan_utf8(state, data + start, end - start);
+            if (status == StatusOk && end == length)
+                status = scan_finish(state);
+            return status;
+        }
+        state->sum += entry.sum;
+        state->lines += entry.lines;
+        state->offset = state->lineStart = end;
+        if (!record(cache, &entry))
+            return StatusNoMemory;
+    }
+    return StatusOk;
+}
@@ -0,0 +1,48 @@
+// This file declares the chunk cache: the results of scanning pieces of an input, remembered between runs,
+// so that after a few lines of a huge input are edited, only the pieces around them are scanned again.
+//
+// scan_cached() in trebuchet.h uses it, and cache.c has the details.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+// stddef.h used for size_t
+#include <stddef.h>
+
+// The result of scanning one chunk, as the cache remembers it.
+typedef struct CACHE_ENTRY
+{
+    unsigned long long hash;    // A hash of the chunk's bytes (see chunk_hash() in cache.c).
+    unsigned long long options; // The options it was scanned with (see options_key() in cache.c).
+    unsigned long long length;  // How many bytes it has.
+    unsigned long long lines;   // How many lines it has.
+    int sum;                    // The sum of their calibration values.
+} cache_entry_t;
+
+// A cache, loaded from a file with cache_load(), and saved back with cache_save().
+typedef struct CHUNK_CACHE
+{
+    cache_entry_t *old;         // The entries that were in the file, sorted by hash, to look chunks up in.
+    size_t oldCount;
+    cache_entry_t *fresh;       // The entries for this run's chunks, in order, to save afterwards.
+    size_t freshCount;
+    size_t freshCapacity;
+    unsigned long long options; // The options of this run's entries.
+
+    // How it went, for --stats.
+    unsigned long long hits;      // Chunks whose result was in the cache.
+    unsigned long long misses;    // Chunks that had to be scanned.
+    unsigned long long hitBytes;  // Bytes in the chunks that were in the cache.
+    unsigned long long bytes;     // Bytes in all the chunks.
+} chunk_cache_t;
+
+// Load the cache at 'path'. A file that doesn't exist yet is an empty cache. Returns NULL, or a message.
+const char *cache_load(chunk_cache_t *cache, const char *path);
+
+// Save this run's entries (and other options' entries from the file) to 'path'. Returns NULL, or a message.
+const char *cache_save(const chunk_cache_t *cache, const char *path);
+
+// Free the memory used by 'cache'.
+void cache_free(chunk_cache_t *cache);
+
+#endif // CACHE_H
@@ -0,0 +1,245 @@
+// This file writes and reads compiled inputs, for compiled.h, and compile_input() and scan_compiled() in trebuchet.h.
+
+/*
+    The format. Numbers are little-endian on every computer, so a compiled input can be copied to any other.
+
+        bytes 0-7    89 'T' 'R' 'B' '\r' '\n' 1A '\n', the "magic number" (see below)
+        bytes 8-11   the format's version, 1
+        bytes 12-15  flags: 1 if the text passed --strict
+        bytes 16-23  how many lines the text had
+        bytes 24-31  how many bytes the text had
+        bytes 32-39  where its first line started (after the BOM)
+        bytes 40-43  how many bytes each newline took (1 or 2)
+        bytes 44-47  0, for now
+        then         a byte for each line: its first digit times 16, plus its last (0xFF: no digits)
+        then         the same again, counting spelled-out English digits too
+        then         each line's length as a varint
+
+    A line's digits fit in a byte, where its text takes 30 or 40, so the file is about a tenth of the text's
+    size, and a sum only reads a third of the file. The digits are all in one array, so summing them is a
+    simple loop that the compiler turns into SIMD instructions itself, and the only limit is how fast memory
+    can deliver them. The lengths are only read to say where lines are (for --top and friends).
+
+    A "varint" stores a number 7 bits at a time, lowest first, in as many bytes as it takes. Each byte's top
+    bit says whether another byte follows. Lines shorter than 128 bytes take one byte.
+
+    The magic number is copied from PNG's. 0x89 can't start a UTF-8 character, so no valid text starts like
+    this. The "\r\n" and "\n" get mangled by file transfers that "fix" line endings, which we'd notice, and
+    0x1A stops the Windows 'type' command from printing the rest.
+
+    See: https://en.wikipedia.org/wiki/PNG#File_header
+    See: https://en.wikipedia.org/wiki/LEB128
+*/
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // For stat(). See input.c in the runtime.
+#endif
+
+// limits.h used for INT_MAX
+#include <limits.h>
+// stdint.h used for SIZE_MAX
+#include <stdint.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// string.h used for memcmp()
+#include <string.h>
+// sys/stat.h used for stat()
+#include <sys/stat.h>
+
+#if !defined(S_ISREG) // Windows has the bits, but not the macro.
+#define S_ISREG(mode) (((mode) & _S_IFMT) == _S_IFREG)
+#endif
+
+#include "tables.h"
+#include "trebuchet.h"
+
+#define HEADER_SIZE 48
+#define VERSION 1
+#define FLAG_STRICT 1u
+
+static const unsigned char Magic[8] = {0x89, 'T', 'R', 'B', '\r', '\n', 0x1A, '\n'};
+
+// Make room for 'extra' more bytes after the 'used' ones in '*bytes', doubling its size until they fit.
+static bool reserve(unsigned char **bytes, size_t *capacity, size_t used, size_t extra)
+{
+    if (extra <= *capacity - used)
+        return true;
+    size_t grown = *capacity == 0 ? 4096 : *capacity;
+    while (grown - used < extra)
+    {
+        if (grown > SIZE_MAX / 2)
+            return false;
+        grown *= 2;
+    }
+    unsigned char *moved = realloc(*bytes, grown);
+    if (moved == NULL)
+        return false;
+    *bytes = moved;
+    *capacity = grown;
+    return true;
+}
+
+bool compiler_add(compiler_t *compiler, unsigned long long length, int value)
+{
+    if (!reserve(&compiler->values, &compiler->capacity, compiler->count, 1))
+        return false;
+    compiler->values[compiler->count++] = value < 0 ? COMPILED_NO_DIGITS : (unsigned char)(value / 10 * 16 + value % 10);
+    if (!compiler->recordLengths)
+        return true;
+    if (!reserve(&compiler->lengths, &compiler->lengthsCapacity, compiler->lengthsSize, 10)) // 64 bits take 10 at most.
+        return false;
+    do
+    {
+        unsigned char byte = length & 0x7F;
+        length >>= 7;
+        compiler->lengths[compiler->lengthsSize++] = byte | (length != 0 ? 0x80 : 0);
+    } while (length != 0);
+    return true;
+}
+
+status_t compile_input(scan_state_t *state, const unsigned char *data, size_t length, FILE *out)
+{
+    /*
+        Scan the text twice: once for the digits, which gives the lengths too, and once more with spelled-out
+        digits. Both scans see the same lines, since words don't change where lines end.
+    */
+    compiler_t digits = {.recordLengths = true}, words = {0};
+    state->compiler = &digits;
+    status_t status = scan_input(state, data, length);
+    if (status == StatusOk)
+    {
+        scan_state_t spelled;
+        scan_init(&spelled);
+        spelled.strict = state->strict;
+        spelled.maxLineLength = state->maxLineLength;
+        spelled.words = &EnglishWords;
+        spelled.compiler = &words;
+        status = scan_input(&spelled, data, length);
+    }
+    state->compiler = NULL;
+
+    if (status == StatusOk)
+    {
+        size_t bomLength;
+        encoding_t encoding = detect_encoding(data, length, &bomLength);
+        unsigned char header[HEADER_SIZE] = {0};
+        memcpy(header, Magic, sizeof Magic);
+        aoc_put_le(header + 8, VERSION, 4);
+        aoc_put_le(header + 12, state->strict ? FLAG_STRICT : 0, 4);
+        aoc_put_le(header + 16, digits.count, 8);
+        aoc_put_le(header + 24, length, 8);
+        aoc_put_le(header + 32, bomLength, 8);
+        aoc_put_le(header + 40, encoding == EncodingUtf16le ? 2 : 1, 4);
+        (void)fwrite(header, 1, sizeof header, out); // The caller checks for errors, with ferror().
+        (void)fwrite(digits.values, 1, digits.count, out);
+        (void)fwrite(words.values, 1, words.count, out);
+        (void)fwrite(digits.lengths, 1, digits.lengthsSize, out);
+    }
+    free(digits.values);
+    free(digits.lengths);
+    free(words.values);
+    return status;
+}
+
+bool compiled_detect(const unsigned char *data, size_t length)
+{
+    return length >= sizeof Magic && memcmp(data, Magic, sizeof Magic) == 0;
+}
+
+bool compiled_file(const char *path)
+{
+    /*
+        Only a regular file can be looked at first and read again after. The bytes we'd read from a pipe (or a
+        FIFO, or bash's <(...)) would be gone before the real read, and opening a FIFO twice waits for a second
+        writer that never comes. Those are loaded as they are, and checked with compiled_detect() then.
+    */
+    struct stat info;
+    if (stat(path, &info) != 0 || !S_ISREG(info.st_mode))
+        return false;
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+    unsigned char start[sizeof Magic];
+    size_t length = fread(start, 1, sizeof start, file);
+    (void)fclose(file);
+    return compiled_detect(start, length);
+}
+
+const char *compiled_open(compiled_t *compiled, const unsigned char *data, size_t length)
+{
+    if (length < HEADER_SIZE || !compiled_detect(data, length))
+        return "Not a compiled input";
+    if (aoc_get_le(data + 8, 4) != VERSION)
+        return "Compiled input from a different version of trebuchet";
+    compiled->lines = aoc_get_le(data + 16, 8);
+    compiled->size = aoc_get_le(data + 24, 8);
+    compiled->start = aoc_get_le(data + 32, 8);
+    compiled->newlineWidth = (unsigned)aoc_get_le(data + 40, 4);
+    compiled->strict = (aoc_get_le(data + 12, 4) & FLAG_STRICT) != 0;
+    if ((compiled->newlineWidth != 1 && compiled->newlineWidth != 2) || compiled->lines > (length - HEADER_SIZE) / 2)
+        return "Damaged compiled input";
+    compiled->digits = data + HEADER_SIZE;
+    compiled->words = compiled->digits + compiled->lines;
+    compiled->lengths = compiled->words + compiled->lines;
+    compiled->lengthsSize = length - HEADER_SIZE - 2 * (size_t)compiled->lines;
+    return NULL;
+}
+
+status_t scan_compiled(scan_state_t *state, const compiled_t *compiled)
+{
+    const unsigned char *values = state->words != NULL ? compiled->words : compiled->digits;
+    state->offset = compiled->size;
+
+    /*
+        Just the sum: add up every line's value in one go. Without an 'if' in the loop (the comparison
+        becomes a mask), the compiler can turn it into SIMD instructions. It adds up in 64 bits, so it
+        can't overflow, and only if the total doesn't fit in the sum do we go line by line to find where.
+    */
+    if (state->outliers == NULL)
+    {
+        unsigned long long total = 0;
+        for (unsigned long long i = 0; i < compiled->lines; i++)
+        {
+            unsigned byte = values[i];
+            total += (byte != COMPILED_NO_DIGITS) * ((byte >> 4) * 10 + (byte & 0xF));
+        }
+        if (total <= (unsigned long long)(INT_MAX - state->sum))
+        {
+            state->sum += (int)total;
+            state->lines += compiled->lines;
+            return StatusOk;
+        }
+    }
+
+    // One line at a time, like end_line() in trebuchet.c.
+    const unsigned char *lengths = compiled->lengths, *end = lengths + compiled->lengthsSize;
+    unsigned long long offset = compiled->start;
+    for (unsigned long long i = 0; i < compiled->lines; i++)
+    {
+        unsigned byte = values[i];
+        int value = byte != COMPILED_NO_DIGITS ? (int)((byte >> 4) * 10 + (byte & 0xF)) : -1;
+        if (value > INT_MAX - state->sum)
+        {
+            state->overflowValue = value;
+            return StatusOverflow;
+        }
+        if (value >= 0)
+            state->sum += value;
+        if (state->outliers != NULL)
+        {
+            unsigned long long length = 0;
+            unsigned shift = 0;
+            do
+            {
+                if (lengths == end || shift > 63)
+                    return StatusDamaged;
+                length |= (unsigned long long)(*lengths & 0x7F) << shift;
+                shift += 7;
+            } while (*lengths++ & 0x80);
+            outliers_add(state->outliers, offset, length, value);
+            offset += length + compiled->newlineWidth;
+        }
+        state->lines++;
+    }
+    return StatusOk;
+}
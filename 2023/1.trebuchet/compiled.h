@@ -0,0 +1,59 @@
+// This file declares "compiled" inputs: what the scanner works out about each line of a text input, stored
+// compactly, so later runs can skip the text. `trebuchet --compile-input out.treb input.txt` writes one,
+// and `trebuchet out.treb` reads it back, like it would the text.
+//
+// compiled.c has the details of the format.
+
+#ifndef COMPILED_H
+#define COMPILED_H
+
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+// stdio.h used for FILE
+#include <stdio.h>
+
+// What a line that has no digits stores, in place of its first and last digit.
+#define COMPILED_NO_DIGITS 0xFF
+
+// A compiled input, read with compiled_open(). The pointers point into the bytes it was read from.
+typedef struct COMPILED
+{
+    unsigned long long lines;     // How many lines the text had.
+    unsigned long long size;      // How many bytes the text had.
+    unsigned long long start;     // Where the text's first line started (after its BOM, if it had one).
+    unsigned newlineWidth;        // How many bytes each newline took: 1 for UTF-8, or 2 for UTF-16.
+    bool strict;                  // Whether the text passed --strict when it was compiled.
+    const unsigned char *digits;  // For each line: its first digit times 16, plus its last, or COMPILED_NO_DIGITS.
+    const unsigned char *words;   // The same, counting spelled-out English digits too, like --spelled.
+    const unsigned char *lengths; // Each line's length in bytes, without the newline, as "varints" (see compiled.c).
+    size_t lengthsSize;           // How many bytes 'lengths' has.
+} compiled_t;
+
+// Whether 'data' starts like a compiled input does. Text never does, so it's safe to check every input.
+bool compiled_detect(const unsigned char *data, size_t length);
+
+// Whether the file at 'path' is a compiled input, from its first few bytes. False if it can't be read, or isn't a
+// regular file (a pipe's bytes can only be read once).
+bool compiled_file(const char *path);
+
+// Read the compiled input in 'data'. Returns NULL, or a message if it isn't one we can read.
+const char *compiled_open(compiled_t *compiled, const unsigned char *data, size_t length);
+
+// What compile_input() in trebuchet.h collects while it scans a text, one line at a time (see end_line() in trebuchet.c).
+typedef struct COMPILER
+{
+    unsigned char *values;  // One byte for each line, like 'digits' in compiled_t.
+    size_t count;           // How many lines there are so far.
+    size_t capacity;        // How many bytes 'values' has room for.
+    bool recordLengths;     // Whether to record the lines' lengths too (only one scan needs to).
+    unsigned char *lengths; // Their lengths, like 'lengths' in compiled_t.
+    size_t lengthsSize;
+    size_t lengthsCapacity;
+} compiler_t;
+
+// Record a line of 'length' bytes, whose calibration value is 'value' (or -1). Returns false if there's no memory.
+bool compiler_add(compiler_t *compiler, unsigned long long length, int value);
+
+#endif // COMPILED_H
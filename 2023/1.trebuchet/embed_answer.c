@@ -0,0 +1,28 @@
+// This file is the whole of trebuchet_embedded: a program that prints an answer worked out while building.
+//
+// answer.h is written by embed_precompute.c, from the input named by TREBUCHET_EMBED_INPUT.
+// Because the answer is just a number in the source code, this program doesn't read anything
+// at all, and prints the same thing every time. That makes it a handy "known good" result to
+// compare later versions of trebuchet against.
+
+// assert.h used for static_assert()
+#include <assert.h>
+// stdio.h used for printing
+#include <stdio.h>
+// stdlib.h used for exit codes
+#include <stdlib.h>
+
+#include "answer.h"
+
+/*
+    static_assert() is checked by the compiler, not when the program runs. If it fails, the build fails.
+
+    See: https://en.cppreference.com/w/c/language/_Static_assert
+*/
+static_assert(TREBUCHET_ANSWER >= 0, "the answer is a sum of positive numbers");
+
+int main(void)
+{
+    (void)printf("Sum = %d\n", TREBUCHET_ANSWER);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+// This file is a small program that works out the answer for an input that's built into it,
+// and writes the answer out as a C header (answer.h).
+//
+// CMake builds and runs it while building trebuchet_embedded, when TREBUCHET_EMBED_INPUT is set.
+// See the bottom of CMakeLists.txt, and embed_answer.c for the program that uses the header.
+//
+// Execute like so:
+//
+// ./trebuchet_precompute answer.h [--strict] [--spelled]
+
+/*
+    Why not work out the answer inside the compiler itself?
+
+    C has "constant expressions", which the compiler evaluates while compiling. C23 even adds
+    'constexpr' variables. But unlike C++, C has no way to run a loop or call a function at
+    compile time, so a whole scan can't be a constant expression.
+
+    The next best thing is to run the scan while building, in this helper program, and hand the
+    result to the compiler as a #define. The final program then only contains the number.
+
+    See: https://en.cppreference.com/w/c/language/constant_expression
+    See: https://en.cppreference.com/w/c/language/constexpr
+*/
+
+// stdio.h used for input/output and file handling
+#include <stdio.h>
+// stdlib.h used for exit codes
+#include <stdlib.h>
+// string.h used for comparing command-line arguments
+#include <string.h>
+
+#include "tables.h"
+#include "trebuchet.h"
+
+/*
+    The input, pasted into the program as an array of bytes.
+
+    With C23's #embed, the preprocessor reads the file and expands to a list like "49, 97, 98, ...".
+    CMake passes the file name in TREBUCHET_EMBED_FILE. Compilers without #embed get the same list
+    from a file that CMake writes while configuring.
+
+    See: https://en.cppreference.com/w/c/preprocessor/embed
+*/
+static const unsigned char Input[] = {
+#ifdef TREBUCHET_HAVE_EMBED
+#embed TREBUCHET_EMBED_FILE
+#else
+#include "embedded_input.inc"
+#endif
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        (void)fprintf(stderr, "Usage: %s OUTPUT [--strict] [--spelled]\n", argv[0] != NULL ? argv[0] : "trebuchet_precompute");
+        return EXIT_FAILURE;
+    }
+
+    scan_state_t state;
+    scan_init(&state);
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--strict") == 0)
+            state.strict = true;
+        else if (strcmp(argv[i], "--spelled") == 0)
+            state.words = &EnglishWords;
+        else
+        {
+            (void)fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // If the input is bad, fail the build rather than bake a wrong answer into the program.
+    status_t status = scan_input(&state, Input, sizeof Input);
+    if (status != StatusOk)
+    {
+        (void)fprintf(stderr, "Embedded input: %s at line %llu, byte offset %llu\n",
+                      status_message(status), state.lines + 1, state.errorOffset);
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL)
+    {
+        (void)fprintf(stderr, "Unable to create file: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    (void)fprintf(out, "// Generated by embed_precompute.c. Don't edit this file.\n\n");
+    (void)fprintf(out, "#define TREBUCHET_ANSWER %d\n", state.sum);
+    (void)fprintf(out, "#define TREBUCHET_INPUT_BYTES %zu\n", sizeof Input);
+    (void)fprintf(out, "#define TREBUCHET_INPUT_LINES %llu\n", state.lines);
+    if (fclose(out) != 0)
+    {
+        (void)fprintf(stderr, "Unable to write file: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+// This file is a small program that writes C source code: the lookup tables declared in tables.h.
+//
+// CMake builds and runs it during the build (see CMakeLists.txt), before compiling trebuchet.
+// That way, trebuchet starts with its tables already built, instead of building them every time it runs.
+//
+// Execute like so:
+//
+// ./gen_tables english.words tables.c
+
+/*
+    Why generate code, rather than build the tables when the program starts?
+
+    1. Startup is free. Building the automaton only takes microseconds, but for a program that
+       runs for a few milliseconds on a small file, it's a cost we'd pay over and over again.
+    2. The tables are 'static const', so the compiler puts them in a read-only section of the
+       executable. The operating system loads those pages straight from the file, and every copy
+       of trebuchet that's running at the same time shares the same physical memory.
+    3. Each table is aligned to 64 bytes, the size of a CPU cache line, so a table never starts
+       partway through a cache line that it has to share with something else.
+
+    See: https://en.wikipedia.org/wiki/Automatic_programming#Source-code_generation
+    See: https://en.wikipedia.org/wiki/Data_segment
+    See: https://en.wikipedia.org/wiki/CPU_cache#Cache_entries
+*/
+
+// stdio.h used for input/output and file handling
+#include <stdio.h>
+// stdlib.h used for exit codes
+#include <stdlib.h>
+
+#include "aoc_runtime.h"
+#include "tables.h"
+#include "words.h"
+
+static char *Argv0; // The name of this program, for error messages.
+
+// Print an error message and exit.
+[[noreturn]] static void die(const char *message, const char *detail)
+{
+    (void)fprintf(stderr, "%s: %s: %s\n", Argv0, message, detail);
+    exit(EXIT_FAILURE);
+}
+
+// Work out the ByteClass[] bits for 'byte'. This is the one place where the rules live.
+static unsigned byte_class(unsigned byte)
+{
+    if (byte >= '0' && byte <= '9')
+        return BYTE_DIGIT;
+    if (byte == '\n')
+        return BYTE_NEWLINE;
+    if ((byte < 0x20 && byte != '\t' && byte != '\r') || byte == 0x7F)
+        return BYTE_CONTROL;
+    if (byte < 0x80)
+        return 0; // Every other ASCII character.
+    if (byte < 0xC0)
+        return BYTE_CONTINUATION;
+    if (byte < 0xC2 || byte > 0xF4) // C0 and C1 could only encode characters "overlong", and F5+ would be above U+10FFFF.
+        return byte < 0xE0 ? BYTE_LEAD | BYTE_INVALID : BYTE_INVALID;
+    return BYTE_LEAD;
+}
+
+// Work out how to decode a character that starts with 'byte'. See the table above see_byte_utf8() in trebuchet.c.
+static utf8_lead_t utf8_lead(unsigned byte)
+{
+    utf8_lead_t lead = {0, 0, 0x80, 0xBF};
+    if (byte >= 0xC0 && byte < 0xE0) // Includes C0 and C1, which are only rejected in strict mode.
+    {
+        lead.pending = 1;
+        lead.mask = 0x1F;
+    }
+    else if (byte >= 0xE0 && byte < 0xF0)
+    {
+        lead.pending = 2;
+        lead.mask = 0x0F;
+        if (byte == 0xE0)
+            lead.lower = 0xA0;
+        else if (byte == 0xED)
+            lead.upper = 0x9F;
+    }
+    else if (byte >= 0xF0 && byte < 0xF5)
+    {
+        lead.pending = 3;
+        lead.mask = 0x07;
+        if (byte == 0xF0)
+            lead.lower = 0x90;
+        else if (byte == 0xF4)
+            lead.upper = 0x8F;
+    }
+    return lead;
+}
+
+// Write 'count' numbers from 'values' as the body of a C array, 16 per line.
+static void write_array(FILE *out, const unsigned short *values, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        (void)fprintf(out, "%s%u,%s", i % 16 == 0 ? "    " : " ", values[i], i % 16 == 15 || i + 1 == count ? "\n" : "");
+}
+
+int main(int argc, char **argv)
+{
+    Argv0 = argv[0] != NULL ? argv[0] : "gen_tables";
+    if (argc != 3)
+    {
+        (void)fprintf(stderr, "Usage: %s VOCABULARY OUTPUT\n", Argv0);
+        return EXIT_FAILURE;
+    }
+
+    // Build the automaton at build time, with exactly the same code that --words uses at run time.
+    aoc_input_t text;
+    const char *error = aoc_input_load(&text, argv[1]);
+    if (error != NULL)
+        die(error, argv[1]);
+    words_t words;
+    unsigned long line;
+    error = words_parse(&words, (const char *)text.data, text.length, &line);
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s:%lu: %s\n", argv[1], line, error);
+        return EXIT_FAILURE;
+    }
+    aoc_input_free(&text);
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL)
+        die("Unable to create file", argv[2]);
+
+    (void)fprintf(out, "// Generated by gen_tables.c from %s. Don't edit this file: edit gen_tables.c, or the vocabulary.\n\n", argv[1]);
+    (void)fprintf(out, "// stdalign.h used for alignas()\n#include <stdalign.h>\n\n#include \"tables.h\"\n\n");
+
+    unsigned short values[256];
+    for (unsigned byte = 0; byte < 256; byte++)
+        values[byte] = (unsigned short)byte_class(byte);
+    (void)fprintf(out, "alignas(64) const unsigned char ByteClass[256] = {\n");
+    write_array(out, values, 256);
+    (void)fprintf(out, "};\n\n");
+
+    (void)fprintf(out, "alignas(64) const utf8_lead_t Utf8Lead[256] = {\n");
+    for (unsigned byte = 0; byte < 256; byte++)
+    {
+        utf8_lead_t lead = utf8_lead(byte);
+        (void)fprintf(out, "    {%u, 0x%02X, 0x%02X, 0x%02X},\n", lead.pending, lead.mask, lead.lower, lead.upper);
+    }
+    (void)fprintf(out, "};\n\n");
+
+    for (unsigned byte = 0; byte < 256; byte++)
+        values[byte] = words.classOf[byte];
+    (void)fprintf(out, "alignas(64) static const unsigned char EnglishClassOf[256] = {\n");
+    write_array(out, values, 256);
+    (void)fprintf(out, "};\n\n");
+
+    (void)fprintf(out, "alignas(64) static const unsigned short EnglishNext[%u] = {\n", words.states * words.classes);
+    write_array(out, words.next, (size_t)words.states * words.classes);
+    (void)fprintf(out, "};\n\n");
+
+    (void)fprintf(out, "alignas(64) static const unsigned short EnglishLongest[%u] = {\n", words.states);
+    write_array(out, words.longest, words.states);
+    (void)fprintf(out, "};\n\n");
+
+    (void)fprintf(out, "alignas(64) static const unsigned short EnglishShortest[%u] = {\n", words.states);
+    write_array(out, words.shortest, words.states);
+    (void)fprintf(out, "};\n\n");
+
+    (void)fprintf(out, "const words_t EnglishWords = {%u, %u, EnglishClassOf, EnglishNext, EnglishLongest, EnglishShortest, NULL};\n",
+                  words.states, words.classes);
+
+    words_free(&words);
+    if (fclose(out) != 0) // fclose() is where buffered output is finally written, so it can fail (e.g. disk full).
+        die("Unable to write file", argv[2]);
+    return EXIT_SUCCESS;
+}
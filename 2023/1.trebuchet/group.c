@@ -0,0 +1,208 @@
+// This file sums each tag's lines separately, for scan_groups() in trebuchet.h, with the hash table from group.h.
+
+// stdint.h used for SIZE_MAX
+#include <stdint.h>
+// stdlib.h used for memory allocation and qsort()
+#include <stdlib.h>
+// string.h used for memchr(), memcmp() and memcpy()
+#include <string.h>
+
+#include "trebuchet.h"
+
+// The first table has this many slots. It has to be a power of 2, like every size after it.
+#define FIRST_CAPACITY 64
+
+void groups_init(groups_t *groups, const char *delimiter, size_t prefix)
+{
+    *groups = (groups_t){.delimiter = delimiter, .prefix = prefix};
+    aoc_arena_init(&groups->tags, 0);
+}
+
+/*
+    Hash a tag with FNV-1a: for each byte, XOR it in, then multiply by a large prime. It's simple,
+    and good enough for short keys like tags. 0 marks an empty slot, so a hash of 0 becomes 1.
+
+    FNV's prime has few bits set, so the last byte barely reaches the top bits, which are the ones find()
+    uses. Tags that differ only at the end (like "t1" and "t2") would all start in neighbouring slots.
+    One more multiplication, by 2^64 divided by the golden ratio ("Fibonacci hashing"), spreads them out.
+
+    See: https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+    See: https://probablydance.com/2018/06/16/fibonacci-hashing-the-optimization-that-the-world-forgot-or-a-better-alternative-to-integer-modulo/
+*/
+static unsigned long long hash_tag(const char *tag, size_t length)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)tag[i]) * 1099511628211ull;
+    hash *= 11400714819323198485ull;
+    return hash != 0 ? hash : 1;
+}
+
+/*
+    Find the slot for 'tag': the one that holds it, or the empty one where it belongs.
+
+    The slot to start at is the hash's top bits ('shift' leaves just enough of them), rather than its bottom
+    bits, because hash_tag()'s last step is a multiplication, which mixes the bytes into the top bits best.
+    'capacity - 1' is all 1s in binary (it's a power of 2), so AND-ing with it wraps around the end of the
+    table, like % but faster.
+*/
+static group_t *find(group_t *slots, size_t capacity, unsigned shift, unsigned long long hash, const char *tag,
+                     size_t length)
+{
+    for (size_t i = (size_t)(hash >> shift);; i = (i + 1) & (capacity - 1))
+    {
+        group_t *slot = &slots[i];
+        if (slot->hash == 0 || (slot->hash == hash && slot->length == length && memcmp(slot->tag, tag, length) == 0))
+            return slot;
+    }
+}
+
+// Move every group into a table twice as big. Their slots change, since the slot depends on the capacity.
+static bool grow(groups_t *groups)
+{
+    size_t capacity = groups->capacity == 0 ? FIRST_CAPACITY : groups->capacity * 2;
+    if (capacity > SIZE_MAX / sizeof(group_t))
+        return false;
+    group_t *slots = calloc(capacity, sizeof *slots);
+    if (slots == NULL)
+        return false;
+    unsigned shift = 64;
+    while ((size_t)1 << (64 - shift) < capacity)
+        shift--;
+    for (size_t i = 0; i < groups->capacity; i++)
+    {
+        const group_t *group = &groups->slots[i];
+        if (group->hash != 0)
+            *find(slots, capacity, shift, group->hash, group->tag, group->length) = *group;
+    }
+    free(groups->slots);
+    groups->slots = slots;
+    groups->capacity = capacity;
+    groups->shift = shift;
+    return true;
+}
+
+bool groups_add(groups_t *groups, const char *tag, size_t length, long long value, unsigned long long lines)
+{
+    if ((groups->count + 1) * 4 > groups->capacity * 3 && !grow(groups)) // Keep it at most 3/4 full.
+        return false;
+    unsigned long long hash = hash_tag(tag, length);
+    group_t *slot = find(groups->slots, groups->capacity, groups->shift, hash, tag, length);
+    if (slot->hash == 0) // A new group. Keep a copy of its tag.
+    {
+        char *copy = aoc_arena_strndup(&groups->tags, tag, length);
+        if (copy == NULL)
+            return false;
+        *slot = (group_t){hash, copy, length, 0, 0};
+        groups->count++;
+    }
+    slot->sum += value;
+    slot->lines += lines;
+    return true;
+}
+
+bool groups_merge(groups_t *into, const groups_t *from)
+{
+    for (size_t i = 0; i < from->capacity; i++)
+    {
+        const group_t *group = &from->slots[i];
+        if (group->hash != 0 && !groups_add(into, group->tag, group->length, group->sum, group->lines))
+            return false;
+    }
+    return true;
+}
+
+// Sort tags like strcmp() would, but they may contain '\0', and they aren't followed by one.
+static int compare_groups(const void *left, const void *right)
+{
+    const group_t *a = *(const group_t *const *)left, *b = *(const group_t *const *)right;
+    int order = memcmp(a->tag, b->tag, a->length < b->length ? a->length : b->length);
+    if (order != 0)
+        return order;
+    return a->length < b->length ? -1 : a->length > b->length;
+}
+
+const group_t **groups_sorted(const groups_t *groups)
+{
+    const group_t **sorted = malloc((groups->count + 1) * sizeof *sorted); // + 1: malloc(0) may return NULL.
+    if (sorted == NULL)
+        return NULL;
+    size_t count = 0;
+    for (size_t i = 0; i < groups->capacity; i++)
+        if (groups->slots[i].hash != 0)
+            sorted[count++] = &groups->slots[i];
+    qsort(sorted, count, sizeof *sorted, compare_groups);
+    return sorted;
+}
+
+void groups_free(groups_t *groups)
+{
+    free(groups->slots);
+    aoc_arena_free(&groups->tags);
+    groups->slots = NULL;
+    groups->capacity = groups->count = 0;
+}
+
+// Find the first 'needle' in 'haystack', or return NULL. Like memmem(), which isn't standard C.
+static const unsigned char *find_text(const unsigned char *haystack, size_t length, const char *needle, size_t needleLength)
+{
+    const unsigned char *end = haystack + length;
+    while (needleLength <= (size_t)(end - haystack))
+    {
+        const unsigned char *first = memchr(haystack, (unsigned char)needle[0], (size_t)(end - haystack) - needleLength + 1);
+        if (first == NULL)
+            return NULL;
+        if (memcmp(first, needle, needleLength) == 0)
+            return first;
+        haystack = first + 1;
+    }
+    return NULL;
+}
+
+status_t scan_groups(scan_state_t *state, const unsigned char *data, size_t length)
+{
+    groups_t *groups = state->groups;
+    size_t delimiterLength = groups->delimiter != NULL ? strlen(groups->delimiter) : 0;
+    const unsigned char *end = data + length;
+    while (data < end)
+    {
+        const unsigned char *newline = memchr(data, '\n', (size_t)(end - data));
+        size_t lineLength = newline != NULL ? (size_t)(newline - data) : (size_t)(end - data);
+
+        /*
+            Split off the tag. A line without the delimiter has no tag, and all of it is calibration text.
+            The tag isn't scanned at all, so digits in it don't count (and strict mode doesn't check it).
+        */
+        size_t tagLength = 0, skip = 0;
+        if (groups->delimiter != NULL)
+        {
+            const unsigned char *delimiter = find_text(data, lineLength, groups->delimiter, delimiterLength);
+            if (delimiter != NULL)
+            {
+                tagLength = (size_t)(delimiter - data);
+                skip = tagLength + delimiterLength;
+            }
+        }
+        else
+            skip = tagLength = lineLength < groups->prefix ? lineLength : groups->prefix;
+        if (tagLength > 0 && tagLength == lineLength && data[tagLength - 1] == '\r') // A short line's "\r\n".
+            tagLength--;
+
+        /*
+            Scan the rest of the line, newline and all, starting from a sum of 0, so the sum afterwards is this
+            line's value. The line without a newline can only be the last one, which scan_finish() ends.
+        */
+        state->offset += skip;
+        state->sum = 0;
+        status_t status = scan_utf8(state, data + skip, lineLength - skip + (newline != NULL));
+        if (status == StatusOk && newline == NULL)
+            status = scan_finish(state);
+        if (status != StatusOk)
+            return status;
+        if (!groups_add(groups, (const char *)data, tagLength, state->sum, 1))
+            return StatusNoMemory;
+        data += lineLength + (newline != NULL);
+    }
+    state->sum = 0; // The values are in the groups now.
+    return StatusOk;
+}
@@ -0,0 +1,69 @@
+// This file declares "groups": a sum for each tag, for inputs whose lines start with one, like "oven-3: 1abc2".
+//
+// scan_groups() in trebuchet.h fills them in, and group.c has the hash table that holds them.
+
+#ifndef GROUP_H
+#define GROUP_H
+
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+
+// aoc_runtime.h declares aoc_arena_t, which holds copies of the tags
+#include "aoc_runtime.h"
+
+// One group: every line with the same tag.
+typedef struct GROUP
+{
+    unsigned long long hash;   // The tag's hash, or 0 for an empty slot in the table.
+    const char *tag;           // The tag's bytes (not followed by '\0'). Empty for lines that have no tag.
+    size_t length;             // How many bytes are in 'tag'.
+    long long sum;             // The sum of the calibration values of the group's lines.
+    unsigned long long lines;  // How many lines are in the group.
+} group_t;
+
+/*
+    A hash table of groups, found by their tag.
+
+    "Open addressing" keeps every group in one array. A tag's hash picks a slot, and if another tag is
+    already there, we try the next slot, and the next (this is "linear probing"), until we find the tag
+    or an empty slot. Looking a tag up usually touches a single cache line, with no pointers to follow,
+    unlike a table of linked lists. The array doubles when it's three quarters full, which keeps the runs
+    of full slots short.
+
+    See: https://en.wikipedia.org/wiki/Open_addressing
+    See: https://en.wikipedia.org/wiki/Linear_probing
+*/
+typedef struct GROUPS
+{
+    // Where a line's tag ends: at the first 'delimiter' (a string), or after 'prefix' bytes if 'delimiter' is NULL.
+    const char *delimiter;
+    size_t prefix;
+
+    group_t *slots;       // The table: 'capacity' slots, a power of 2 (or NULL, before the first group).
+    size_t capacity;
+    unsigned shift;       // 64 - log2(capacity): a hash's top bits pick the first slot to try (see find() in group.c).
+    size_t count;         // How many slots are full.
+    aoc_arena_t tags;     // Copies of the tags, since the input they came from may be gone by the time we print.
+} groups_t;
+
+// Start an empty table of groups, whose tags end at 'delimiter', or after 'prefix' bytes if 'delimiter' is NULL.
+void groups_init(groups_t *groups, const char *delimiter, size_t prefix);
+
+// Add a line with 'value', tagged 'tag', to its group. Returns false if there's no memory for a new group.
+bool groups_add(groups_t *groups, const char *tag, size_t length, long long value, unsigned long long lines);
+
+// Add every group in 'from' to 'into'. Returns false if there's no memory for a new group.
+bool groups_merge(groups_t *into, const groups_t *from);
+
+/*
+    Return an array of pointers to every group, sorted by tag, for printing. There are 'count' of them.
+    Free the array with free() (but not the groups, which belong to 'groups'). Returns NULL if there's no memory.
+*/
+const group_t **groups_sorted(const groups_t *groups);
+
+// Free the memory used by 'groups'.
+void groups_free(groups_t *groups);
+
+#endif // GROUP_H
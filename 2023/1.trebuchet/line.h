@@ -0,0 +1,193 @@
+// This file works out the calibration value of one line, for programs that already have their lines in hand.
+//
+// scan_input() (in trebuchet.h) is made for whole inputs: it keeps its place in a scan_state_t, so an input
+// can come in pieces, and it checks for errors, counts lines, and so on. A program that already has each
+// line as a pointer and a length doesn't need any of that. Calling scan_input() on every line would cost
+// far more than the line itself, so everything here is 'static inline': there's nothing to link, and the
+// compiler pastes the code into the caller's loop, where it's a few dozen instructions for a short line.
+//
+// It only knows ASCII. A line with other bytes gets LINE_NOT_ASCII back, and should go to scan_input(),
+// which knows the digits of other scripts (see unicode_digit() in trebuchet.h). line_check.c checks that both
+// give the same answers.
+
+#ifndef LINE_H
+#define LINE_H
+
+// stddef.h used for size_t
+#include <stddef.h>
+// stdint.h used for uint64_t
+#include <stdint.h>
+// string.h used for memcmp()
+#include <string.h>
+
+#if defined(_MSC_VER)
+// intrin.h used for _BitScanForward64() and _BitScanReverse64()
+#include <intrin.h>
+#endif
+
+#define LINE_NO_DIGITS (-1) // The line has no digits, so it adds nothing to the sum.
+#define LINE_NOT_ASCII (-2) // The line has bytes that aren't ASCII: ask scan_input() instead.
+
+/*
+    SWAR stands for "SIMD Within A Register": treating an ordinary 64-bit number as 8 bytes side by side, and
+    working on all 8 at once with ordinary arithmetic. Unlike SSE2 (see trebuchet.c), it works on every CPU,
+    and there's nothing to set up, which suits lines that are only a few dozen bytes long.
+
+    See: https://en.wikipedia.org/wiki/SWAR
+    See: https://graphics.stanford.edu/~seander/bithacks.html#ZeroInWord
+*/
+#define LINE_ONES 0x0101010101010101ull
+#define LINE_HIGH 0x8080808080808080ull // The top bit of each byte.
+
+/*
+    Load 'length' bytes (8 at most) at 'data' into a number, the first byte lowest, and the rest zeros. Zero
+    bytes aren't digits (or letters), so they can't change the answer. The compiler turns this loop into a
+    single load when 'length' is 8, and byte order doesn't matter: it's the same on every CPU.
+*/
+static inline uint64_t line_load(const unsigned char *data, size_t length)
+{
+    uint64_t word = 0;
+    for (size_t i = 0; i < length; i++)
+        word |= (uint64_t)data[i] << (8 * i);
+    return word;
+}
+
+// Which of the bytes in 'word' are ASCII digits ('0' to '9'): the top bit of each one is set, and nothing else.
+static inline uint64_t line_digits(uint64_t word)
+{
+    /*
+        XOR with '0' turns the digits into the bytes 0 to 9. Adding 0x76 (118) to a byte sets its top bit if it
+        was 10 or more. The "& 0x7F" first keeps each sum below 256, so no carry spills into the next byte,
+        and OR-ing the word back in catches the bytes that had their top bit set already.
+    */
+    uint64_t offset = word ^ (0x30 * LINE_ONES);
+    uint64_t notDigit = ((offset & ~LINE_HIGH) + 0x76 * LINE_ONES) | offset;
+    return ~notDigit & LINE_HIGH;
+}
+
+// Which byte of a word the lowest (or highest) set bit of 'mask' is in. 'mask' must not be zero.
+static inline unsigned line_first_byte(uint64_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return (unsigned)index / 8;
+#else
+    return (unsigned)__builtin_ctzll(mask) / 8;
+#endif
+}
+
+static inline unsigned line_last_byte(uint64_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, mask);
+    return (unsigned)index / 8;
+#else
+    return (63 - (unsigned)__builtin_clzll(mask)) / 8;
+#endif
+}
+
+/*
+    The calibration value of the 'length' bytes at 'line' (without the newline): its first digit times 10,
+    plus its last. A line with one digit uses it twice. Returns LINE_NO_DIGITS or LINE_NOT_ASCII otherwise.
+
+    It goes through the line 8 bytes at a time, and keeps the first and last words that have digits in them.
+    There's no early exit, because a non-ASCII digit could come anywhere.
+*/
+static inline int line_value(const unsigned char *line, size_t length)
+{
+    uint64_t seen = 0;                   // Every byte OR-ed together, to see if any has its top bit set.
+    uint64_t firstWord = 0, lastWord = 0; // The first and last words with digits, XOR-ed with '0'.
+    uint64_t firstMask = 0, lastMask = 0; // And which of their bytes are digits.
+    for (size_t i = 0; i < length; i += 8)
+    {
+        uint64_t word = line_load(line + i, length - i < 8 ? length - i : 8);
+        uint64_t digits = line_digits(word);
+        seen |= word;
+        if (digits != 0 && firstMask == 0)
+        {
+            firstWord = word;
+            firstMask = digits;
+        }
+        if (digits != 0)
+        {
+            lastWord = word;
+            lastMask = digits;
+        }
+    }
+    if ((seen & LINE_HIGH) != 0)
+        return LINE_NOT_ASCII;
+    if (firstMask == 0)
+        return LINE_NO_DIGITS;
+    unsigned first = (unsigned)(firstWord >> (8 * line_first_byte(firstMask))) & 0xF; // '0' to '9' is 0x30 to 0x39.
+    unsigned last = (unsigned)(lastWord >> (8 * line_last_byte(lastMask))) & 0xF;
+    return (int)(first * 10 + last);
+}
+
+/*
+    The digit that starts at line[i], written as a digit or spelled out in English ("one" to "nine"), or -1.
+    Every word has a different first letter or second letter, so one or two comparisons find it.
+*/
+static inline int line_match(const unsigned char *line, size_t length, size_t i)
+{
+    size_t left = length - i;
+#define LINE_WORD(word, digit)                                                                                 \
+    if (left >= sizeof word - 1 && memcmp(line + i, word, sizeof word - 1) == 0)                              \
+        return digit;
+    switch (line[i])
+    {
+    case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+        return line[i] - '0';
+    case 'o':
+        LINE_WORD("one", 1)
+        break;
+    case 't':
+        LINE_WORD("two", 2)
+        LINE_WORD("three", 3)
+        break;
+    case 'f':
+        LINE_WORD("four", 4)
+        LINE_WORD("five", 5)
+        break;
+    case 's':
+        LINE_WORD("six", 6)
+        LINE_WORD("seven", 7)
+        break;
+    case 'e':
+        LINE_WORD("eight", 8)
+        break;
+    case 'n':
+        LINE_WORD("nine", 9)
+        break;
+    default:
+        break;
+    }
+#undef LINE_WORD
+    return -1;
+}
+
+/*
+    Like line_value(), counting spelled-out digits too, like --spelled: "two1nine" is 29. Words can overlap,
+    and then each one counts, so "eightwo" is 82.
+
+    The first digit is the one that starts first, and the last is the one that starts last, so we look from
+    the start for one, and from the end for the other, and usually stop after a few bytes. The SWAR check
+    that the line is ASCII comes first, since it's only one OR per 8 bytes.
+*/
+static inline int line_value_spelled(const unsigned char *line, size_t length)
+{
+    uint64_t seen = 0;
+    for (size_t i = 0; i < length; i += 8)
+        seen |= line_load(line + i, length - i < 8 ? length - i : 8);
+    if ((seen & LINE_HIGH) != 0)
+        return LINE_NOT_ASCII;
+    int first = -1, last = -1;
+    for (size_t i = 0; i < length && first < 0; i++)
+        first = line_match(line, length, i);
+    for (size_t i = length; i > 0 && last < 0; i--)
+        last = line_match(line, length, i - 1);
+    return first < 0 ? LINE_NO_DIGITS : first * 10 + last;
+}
+
+#endif // LINE_H
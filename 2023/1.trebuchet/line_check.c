@@ -0,0 +1,73 @@
+// This file is a small program that checks line.h against the scanner: it works out each line's value both
+// ways, and complains about any line where they differ. CMakeLists.txt runs it on the example inputs.
+//
+// Execute like so:
+//
+// ./line_check [--spelled] input.txt
+
+// stdio.h used for input/output
+#include <stdio.h>
+// stdlib.h used for exit codes
+#include <stdlib.h>
+// string.h used for memchr() and comparing command-line arguments
+#include <string.h>
+
+#include "line.h"
+#include "tables.h"
+#include "trebuchet.h"
+
+int main(int argc, char **argv)
+{
+    bool spelled = argc == 3 && strcmp(argv[1], "--spelled") == 0;
+    if (argc != (spelled ? 3 : 2))
+    {
+        (void)fprintf(stderr, "Usage: %s [--spelled] INPUT\n", argv[0] != NULL ? argv[0] : "line_check");
+        return EXIT_FAILURE;
+    }
+    const char *path = argv[argc - 1];
+    aoc_input_t input;
+    const char *error = aoc_input_load(&input, path);
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s\n", error, path);
+        return EXIT_FAILURE;
+    }
+
+    // One line at a time, the way a program with its lines in hand would use line.h.
+    long long sum = 0;
+    unsigned long long number = 0, fallbacks = 0;
+    int status = EXIT_SUCCESS;
+    const unsigned char *line = input.data, *end = input.data + input.length;
+    while (line < end)
+    {
+        const unsigned char *newline = memchr(line, '\n', (size_t)(end - line));
+        size_t length = (size_t)((newline != NULL ? newline : end) - line);
+        number++;
+
+        // The scanner's answer, for this line on its own. A line without digits adds 0.
+        scan_state_t state;
+        scan_init(&state);
+        state.words = spelled ? &EnglishWords : NULL;
+        status_t scanned = scan_input(&state, line, length);
+
+        int value = spelled ? line_value_spelled(line, length) : line_value(line, length);
+        if (value == LINE_NOT_ASCII) // What line.h asks for: the scanner knows what to do with it.
+        {
+            value = state.sum;
+            fallbacks++;
+        }
+        if (value == LINE_NO_DIGITS)
+            value = 0;
+        if (scanned != StatusOk || value != state.sum)
+        {
+            (void)printf("line %llu: line.h says %d, the scanner %d (%s)\n", number, value, state.sum,
+                         status_message(scanned));
+            status = EXIT_FAILURE;
+        }
+        sum += value;
+        line += length + 1;
+    }
+    aoc_input_free(&input);
+    (void)printf("%llu lines, %llu not ASCII\nSum = %lld\n", number, fallbacks, sum);
+    return status;
+}
@@ -8,16 +8,25 @@
         https://cplusplus.com/reference/clibrary/ (not as detailed)
 */
 
-// assert.h used for the assert() function call
-#include <assert.h>
-// ctype.h used for handling character types
-#include <ctype.h>
+// errno.h used for checking errors from strtoull()
+#include <errno.h>
 // limits.h used for upper/lower bounds on types
 #include <limits.h>
 // stdio.h used for input/output and file handling
 #include <stdio.h>
-// stdlib.h used for converting a string to an integer
+// stdint.h used for SIZE_MAX
+#include <stdint.h>
+// stdlib.h used for exit codes
 #include <stdlib.h>
+// string.h used for comparing command-line arguments, and memchr()
+#include <string.h>
+
+// aoc_runtime.h declares the helpers shared by every day, like loading the input and timing.
+#include "aoc_runtime.h"
+// tables.h declares the lookup tables generated while building, like the English words for --spelled.
+#include "tables.h"
+// trebuchet.h declares the scanner, which does the actual work of summing the input.
+#include "trebuchet.h"
 
 /*
     This is the name of our program.
@@ -29,32 +38,20 @@
 static char *Argv0;
 
 /*
-    Seen describes how many numbers we've seen this line,
-    ranging from 0 until 2.
-
-    Enums are, by default, an integer which starts at 0 and goes up by 1 each time.
-    So we can treat this like an integer.
-
-    Enumerations in C are data types that let us assign human-readable names
-    to special constant values.
-
-    The 'typedef' says that 'seen_t' is a type alias for 'enum SEEN'.
-    Without the typedef, we'd have to use 'enum SEEN x = SeenZero;' to
-    declare and initialize an 'enum SEEN' type. Because of the typedef, we
-    can write 'seen_t x = SeenZero;'.
+    What we exit with when --deadline passed before the end of the input: the results are right, but only
+    for the start of it. It's the same as the 'timeout' command's, which scripts may already check for.
 
-    See: https://en.cppreference.com/w/cpp/language/enum
-    See: https://en.cppreference.com/w/c/language/typedef
+    See: https://www.gnu.org/software/coreutils/manual/html_node/timeout-invocation.html
+*/
+#define EXIT_DEADLINE 124
 
+// The progress page from --progress, which remove_progress() removes when the program ends.
+static aoc_progress_t *SharedProgress;
 
-    Wikipedia or Geeks for Geeks are other online resources.
-*/
-typedef enum SEEN
+static void remove_progress(void)
 {
-    SeenZero,
-    SeenOne,
-    SeenTwo
-} seen_t;
+    aoc_progress_unshare(SharedProgress);
+}
 
 /*
     Prints the program's usage message, then terminates with failure.
@@ -78,10 +75,276 @@ typedef enum SEEN
 {
     // For details about the format of a usage string, check out: https://en.wikipedia.org/wiki/Usage_message
 
-    (void)fprintf(stderr, "Usage: %s [filename]\n", Argv0); // fprintf returns a status code, which we silently ignore.
+    (void)fprintf(stderr, "Usage: %s [--strict] [--max-line-length BYTES] [--spelled | --words VOCABULARY] [--group-delim TEXT | --group-prefix BYTES] [--where [^]TEXT] [--top K] [--bottom K] [--no-digits K] [--longest K] [--compile-input OUTPUT] [--cache PATH] [--tee] [--report FILE] [--stats] [--threads N] [--block-size BYTES] [--cpus LIST] [--background] [--rate BYTES] [--io auto|map|read|direct] [--progress] [--deadline MS] [--aggregate-into FILE] [filename | --batch filename... | --fan-in filename... | --watch PID | --aggregate-read FILE]\n", Argv0); // fprintf returns a status code, which we silently ignore.
     exit(EXIT_FAILURE);
 }
 
+/*
+    Converts the command-line argument 'text' to a positive number, or prints the usage message.
+
+    strtoull() stops at the first character that isn't part of a number, and tells us where
+    that was through 'end'. If 'end' isn't at the end of the string, there was junk after the
+    number (like "12abc"), so we reject it.
+
+    See: https://en.cppreference.com/w/c/string/byte/strtoul
+*/
+static size_t parse_size(const char *text)
+{
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value == 0 || value > SIZE_MAX || text[0] == '-')
+        usage();
+    return (size_t)value;
+}
+
+/*
+    Loads the vocabulary file at 'path' into 'words', or prints an error and exits.
+
+    The file lists spelled-out digits, one per line, like "eins 1". See words_parse() in words.h.
+*/
+static void load_words(const char *path, words_t *words)
+{
+    aoc_input_t text;
+    const char *error = aoc_input_load(&text, path);
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s", error, path);
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long line;
+    error = words_parse(words, (const char *)text.data, text.length, &line);
+    aoc_input_free(&text);
+    if (error != NULL) // Print the error like a compiler does, "file:line: message", so editors can jump to it.
+    {
+        (void)fprintf(stderr, "%s:%lu: %s\n", path, line, error);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*
+    Writes 'input' to the file at 'output' as a compiled input, for --compile-input. If the scan fails
+    (like it would without --compile-input), the file is removed again, and the caller reports why.
+*/
+static status_t compile(scan_state_t *state, const aoc_input_t *input, const char *output)
+{
+    FILE *out = fopen(output, "wb"); // "b": binary, or Windows would turn each '\n' into "\r\n".
+    if (out == NULL)
+    {
+        (void)fprintf(stderr, "Unable to create file: %s", output);
+        exit(EXIT_FAILURE);
+    }
+    status_t status = compile_input(state, input->data, input->length, out);
+    bool failed = ferror(out) != 0;
+    failed |= fclose(out) != 0; // fclose() writes whatever is still buffered, so it can fail too.
+    if (failed || status != StatusOk)
+        (void)remove(output);
+    if (failed)
+    {
+        (void)fprintf(stderr, "Unable to write file: %s", output);
+        exit(EXIT_FAILURE);
+    }
+    return status;
+}
+
+/*
+    Scans a compiled input (see compiled.h), or prints why it can't and exits. A compiled input only has
+    what it needs for the sum, with or without --spelled, and for --top and friends.
+*/
+static status_t scan_compiled_input(scan_state_t *state, const aoc_input_t *input, const char *path, bool grouped,
+                                    bool vocabulary)
+{
+    compiled_t compiled;
+    const char *error = compiled_open(&compiled, input->data, input->length);
+    if (error == NULL && grouped)
+        error = "Compiled inputs don't have the tags for --group-delim or --group-prefix";
+    if (error == NULL && vocabulary)
+        error = "Compiled inputs only know spelled-out English digits (--spelled), not --words";
+    if (error == NULL && state->where != NULL)
+        error = "Compiled inputs don't have the text for --where";
+    if (error == NULL && state->strict && !compiled.strict)
+        error = "Compile the input with --strict to scan it with --strict";
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s\n", error, path ? path : "stdin");
+        exit(EXIT_FAILURE);
+    }
+    return scan_compiled(state, &compiled);
+}
+
+/*
+    Prints the lines that --top, --bottom, --no-digits and --longest asked for, best first.
+
+    Only where they are: the input may be gone by now (the pipeline only keeps a few blocks of it at a time),
+    but `tail -c +OFFSET file | head -1` shows a line, from its offset plus 1 (tail counts from 1).
+*/
+static void print_outliers(FILE *out, outliers_t *outliers)
+{
+    static const char *const RankNames[RankCount] = {"top", "bottom", "no digits", "longest"};
+    for (int rank = 0; rank < RankCount; rank++)
+    {
+        outliers_sort(outliers, (rank_t)rank);
+        for (size_t i = 0; i < outliers->count[rank]; i++)
+        {
+            const outlier_line_t *line = &outliers->lines[rank][i];
+            (void)fprintf(out, "%-12s byte %llu, %llu bytes", RankNames[rank], line->offset, line->length);
+            if (line->value >= 0)
+                (void)fprintf(out, ", value %d", line->value);
+            (void)fprintf(out, "\n");
+        }
+    }
+}
+
+/*
+    Closes the file that --report wrote to (if there was one), and checks that everything made it there.
+    Returns 'status' for main() to exit with, or EXIT_FAILURE if it didn't.
+*/
+static int close_report(FILE *report, const char *reportPath, int status)
+{
+    if (reportPath == NULL)
+        return status;
+    bool failed = ferror(report) != 0;
+    failed |= fclose(report) != 0; // fclose() writes whatever is still buffered, so it can fail too.
+    if (failed)
+    {
+        (void)fprintf(stderr, "Unable to write file: %s", reportPath);
+        return EXIT_FAILURE;
+    }
+    return status;
+}
+
+/*
+    With --deadline, say how far the scan got before the deadline passed, and how fast it was going, so the
+    results can be read as those of the first 'bytes' of the input. 'started' is when the clock started.
+*/
+static void print_deadline(FILE *out, unsigned long long started, unsigned long long bytes, unsigned long long lines)
+{
+    double seconds = (double)(aoc_now_ns() - started) / 1e9;
+    (void)fprintf(out, "Deadline passed after %.3f ms: these are the results for the first %llu bytes (%llu lines), "
+                       "scanned at %.3f GB/s\n", seconds * 1e3, bytes, lines, seconds > 0 ? (double)bytes / seconds / 1e9 : 0);
+}
+
+/*
+    Add this run's results to the aggregate file at 'path' from --aggregate-into (if there is one), or exit with
+    an error. Several processes can do this at once: see aoc_aggregate_add().
+*/
+static void aggregate(const char *path, unsigned long long bytes, unsigned long long lines, long long sum)
+{
+    if (path == NULL)
+        return;
+    const char *error = aoc_aggregate_add(path, &(aoc_totals_t){.runs = 1, .bytes = bytes, .lines = lines, .sum = sum});
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s", error, path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Print the sum of the file at 'path', or what went wrong with it, for --batch and --fan-in.
+static void print_result(const char *path, const scan_result_t *result)
+{
+    if (result->status == StatusOk)
+        (void)printf("%s: Sum = %d\n", path, result->sum);
+    else if (result->status == StatusOverflow) // The same numbers as the INTEGER OVERFLOW message for one file.
+        (void)printf("%s: %s: %d + %d > %d\n", path, status_message(result->status), result->sum,
+                     result->overflowValue, INT_MAX);
+    else if (result->status == StatusUnsupported || result->status == StatusCompiled)
+        (void)printf("%s: %s\n", path, status_message(result->status));
+    else
+        (void)printf("%s: %s at line %llu, byte offset %llu\n", path, status_message(result->status),
+                     result->lines + 1, result->errorOffset);
+}
+
+/*
+    Scans every file in 'paths' with scan_batch(), and prints each one's sum, for --batch.
+    Returns EXIT_SUCCESS, or EXIT_FAILURE if any file couldn't be read or scanned.
+*/
+static int run_batch(const char **paths, size_t count, const scan_state_t *options)
+{
+    aoc_input_t *inputs = calloc(count, sizeof *inputs);
+    aoc_span_t *documents = calloc(count, sizeof *documents);
+    scan_result_t *results = calloc(count, sizeof *results);
+    if (inputs == NULL || documents == NULL || results == NULL)
+    {
+        (void)fprintf(stderr, "Out of memory");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const char *error = aoc_input_load(&inputs[i], paths[i]);
+        if (error != NULL)
+        {
+            (void)fprintf(stderr, "%s: %s", error, paths[i]);
+            exit(EXIT_FAILURE);
+        }
+        documents[i] = (aoc_span_t){(const char *)inputs[i].data, inputs[i].length};
+    }
+
+    scan_batch(options, documents, count, results);
+
+    int status = EXIT_SUCCESS;
+    for (size_t i = 0; i < count; i++)
+    {
+        print_result(paths[i], &results[i]);
+        if (results[i].status != StatusOk)
+            status = EXIT_FAILURE;
+        aoc_input_free(&inputs[i]);
+    }
+    free(inputs);
+    free(documents);
+    free(results);
+    return status;
+}
+
+/*
+    Scans every file in 'paths' at once with scan_fan_in(), for --fan-in, and prints each one's sum, then the
+    total. Returns EXIT_SUCCESS, or EXIT_FAILURE if any file couldn't be scanned. Then there's no total, since
+    one that left a file out would look like the right answer.
+*/
+static int run_fan_in(const char **paths, size_t count, const scan_state_t *options, aoc_pipeline_t *pipeline,
+                      unsigned long long started)
+{
+    scan_result_t *results = calloc(count, sizeof *results);
+    if (results == NULL)
+    {
+        (void)fprintf(stderr, "Out of memory");
+        exit(EXIT_FAILURE);
+    }
+    const char *error = scan_fan_in(options, pipeline, paths, count, results);
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s", error, paths[pipeline->failed]);
+        exit(EXIT_FAILURE);
+    }
+
+    int status = pipeline->expired ? EXIT_DEADLINE : EXIT_SUCCESS;
+    long long total = 0; // Each file's sum fits in an int, but all of them together may not.
+    unsigned long long lines = 0;
+    size_t failed = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        print_result(paths[i], &results[i]);
+        if (results[i].status == StatusOk)
+            total += results[i].sum;
+        else
+            failed++;
+        lines += results[i].lines;
+    }
+    if (pipeline->expired)
+        print_deadline(stdout, started, pipeline->bytes, lines);
+    if (failed > 0)
+    {
+        (void)fflush(stdout); // So this comes after the sums, when both go to the same place.
+        (void)fprintf(stderr, "%zu of %zu inputs failed, so there's no total\n", failed, count);
+        status = EXIT_FAILURE;
+    }
+    else
+        (void)printf("Sum = %lld\n", total);
+    free(results);
+    return status;
+}
+
 // Execute like so:
 //
 // cat basic01.txt | ./trebuchet.exe
@@ -89,6 +352,31 @@ typedef enum SEEN
 // OR
 //
 // ./trebuchet.exe basic01.txt
+//
+// Add --strict to reject malformed input (see "Misc info: Strict mode" at the bottom of this file).
+// Add --spelled to also count spelled-out digits like "one" (see "Misc info: Spelled-out digits"),
+// or --words multilingual.words for a vocabulary of your own.
+// Add --batch to scan several files at once, printing a sum for each one.
+// Add --fan-in to read several FIFOs at once, as other programs write lines into them, printing a sum for
+// each one and then the total (see "Misc info: Fan-in").
+// Add --group-delim ": " to sum lines like "oven-3: 1abc2" by their tag ("oven-3"), or --group-prefix 6 for
+// tags that are always 6 bytes long. Each tag's sum is printed, sorted by tag, then the total.
+// Add --where "mill" to only add up the lines that contain "mill", or --where "^mill" for the lines that
+// start with it, like grep, but without a second pass over the input (see where_matches() in trebuchet.c).
+// Add --top 10 to also print where the 10 lines with the highest values are, or --bottom, --no-digits and
+// --longest for the lowest values, the first lines without digits, and the longest lines.
+// Add --compile-input input.treb to write a compact copy of the input, which later runs read instead of the
+// text, much faster (see "Misc info: Compiled inputs").
+// Add --cache input.cache to remember the results of pieces of the input, so that after editing a few lines
+// of a big input, the next run only scans the pieces around them (see "Misc info: The chunk cache").
+// Add --tee to pass the input through to standard output, unchanged, so trebuchet can sit in the middle of
+// a pipeline, like `zcat input.gz | trebuchet --tee | gzip > copy.gz`. The sum goes to standard error then.
+// Add --report sum.txt to write the sum (and anything else we'd print) to sum.txt instead.
+// Add --deadline 200 to stop after 200 milliseconds, if it's not done by then, with the results for the part
+// of the input it got through, and exit with 124 (see expired() in pipeline.c).
+// Add --aggregate-into totals.agg to add the sum to the totals in totals.agg, which many trebuchets can do at
+// once, and run `trebuchet --aggregate-read totals.agg` to print the totals at any time (see aggregate.c in
+// the runtime folder).
 int main(int argc, char **argv)
 {
     // Handling command-line arguments.
@@ -96,88 +384,502 @@ int main(int argc, char **argv)
         Argv0 = "main";  // Default name for error messages is 'main'.
     else
         Argv0 = argv[0]; // Default name for error messages is the program's name.
-    if (argc > 2)        // If you passed in more arguments than we expect, exit.
+
+    // Options start with "--". Anything else is the name of the file to read.
+    const char *path = NULL;                        // The file to read, or NULL for stdin.
+    const char **paths = malloc((size_t)argc * sizeof *paths); // Every file named, for --batch and --fan-in.
+    size_t pathCount = 0;                           // How many files were named.
+    bool batch = false;                             // Whether --batch was passed.
+    bool fanIn = false;                             // Whether --fan-in was passed.
+    bool strict = false;                            // Whether --strict was passed.
+    size_t maxLineLength = DEFAULT_MAX_LINE_LENGTH; // Used by --strict.
+    const char *wordsPath = NULL;                   // The vocabulary file from --words, or NULL.
+    bool spelled = false;                           // Whether --spelled was passed.
+    const char *groupDelimiter = NULL;              // Where tags end, from --group-delim, or NULL.
+    size_t groupPrefix = 0;                         // How long tags are, from --group-prefix (0: no groups).
+    const char *wherePattern = NULL;                // Which lines count, from --where, or NULL for all of them.
+    size_t ranks[RankCount] = {0};                  // How many lines --top, --bottom... print (0: none).
+    const char *compileOutput = NULL;               // Where --compile-input writes the compiled input, or NULL.
+    const char *cachePath = NULL;                   // The cache file from --cache, or NULL.
+    bool tee = false;                               // Whether --tee was passed.
+    const char *reportPath = NULL;                  // Where --report writes the results, or NULL.
+    bool stats = false;                             // Whether --stats was passed.
+    unsigned long long threads = 0;                 // The number of threads from --threads (0: work it out).
+    size_t blockSize = 0;                           // The block size from --block-size (0: work it out).
+    const char *cpuList = NULL;                     // The CPUs from --cpus, like "0-3,8", or NULL.
+    bool background = false;                        // Whether --background was passed.
+    size_t rate = 0;                                // The bytes per second from --rate (0: as fast as we can).
+    const char *io = NULL;                          // How to read the file, from --io, or NULL to decide for itself.
+    bool shareProgress = false;                     // Whether --progress was passed.
+    size_t watch = 0;                               // The process ID from --watch (0: don't watch).
+    size_t deadline = 0;                            // The milliseconds from --deadline (0: no deadline).
+    const char *aggregatePath = NULL;               // The aggregate file from --aggregate-into, or NULL.
+    const char *aggregateRead = NULL;               // The aggregate file from --aggregate-read, or NULL.
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--strict") == 0)
+            strict = true;
+        else if (strcmp(argv[i], "--max-line-length") == 0 && i + 1 < argc)
+            maxLineLength = parse_size(argv[++i]); // ++i: the number is the next argument, so skip over it.
+        else if (strcmp(argv[i], "--words") == 0 && i + 1 < argc)
+            wordsPath = argv[++i];
+        else if (strcmp(argv[i], "--spelled") == 0)
+            spelled = true;
+        else if (strcmp(argv[i], "--group-delim") == 0 && i + 1 < argc)
+            groupDelimiter = argv[++i];
+        else if (strcmp(argv[i], "--group-prefix") == 0 && i + 1 < argc)
+            groupPrefix = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--where") == 0 && i + 1 < argc)
+            wherePattern = argv[++i];
+        else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+            ranks[RankTop] = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--bottom") == 0 && i + 1 < argc)
+            ranks[RankBottom] = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--no-digits") == 0 && i + 1 < argc)
+            ranks[RankNoDigits] = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--longest") == 0 && i + 1 < argc)
+            ranks[RankLongest] = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--compile-input") == 0 && i + 1 < argc)
+            compileOutput = argv[++i];
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            cachePath = argv[++i];
+        else if (strcmp(argv[i], "--tee") == 0)
+            tee = true;
+        else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc)
+            reportPath = argv[++i];
+        else if (strcmp(argv[i], "--stats") == 0)
+            stats = true;
+        else if (strcmp(argv[i], "--batch") == 0)
+            batch = true;
+        else if (strcmp(argv[i], "--fan-in") == 0)
+            fanIn = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--block-size") == 0 && i + 1 < argc)
+            blockSize = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc)
+            cpuList = argv[++i];
+        else if (strcmp(argv[i], "--background") == 0)
+            background = true;
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            rate = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--io") == 0 && i + 1 < argc)
+            io = argv[++i];
+        else if (strcmp(argv[i], "--progress") == 0)
+            shareProgress = true;
+        else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+            watch = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc)
+            deadline = parse_size(argv[++i]);
+        else if (strcmp(argv[i], "--aggregate-into") == 0 && i + 1 < argc)
+            aggregatePath = argv[++i];
+        else if (strcmp(argv[i], "--aggregate-read") == 0 && i + 1 < argc)
+            aggregateRead = argv[++i];
+        else if (argv[i][0] == '-' && argv[i][1] != '\0') // An option we don't know.
+            usage();
+        else if (paths != NULL)
+            paths[pathCount++] = argv[i];
+    }
+
+    if (paths == NULL)
+    {
+        (void)fprintf(stderr, "Out of memory");
+        exit(EXIT_FAILURE);
+    }
+    if (spelled && wordsPath != NULL) // Only one vocabulary at a time.
+        usage();
+    if (batch || fanIn ? pathCount == 0 : pathCount > 1) // --batch needs files, and otherwise, we expect one at most.
+        usage();
+    if (fanIn && batch)
+        usage();
+    bool grouped = groupDelimiter != NULL || groupPrefix != 0;
+    if ((groupDelimiter != NULL && (groupPrefix != 0 || groupDelimiter[0] == '\0')) || (grouped && batch))
+        usage(); // One way to find tags, that can find something, and not with --batch, which has a sum per file.
+    bool ranked = false;
+    for (int rank = 0; rank < RankCount; rank++)
+        ranked |= ranks[rank] != 0;
+    if (ranked && batch) // scan_batch() doesn't look at lines one at a time.
+        usage();
+    if (compileOutput != NULL && (batch || grouped || ranked || spelled || wordsPath != NULL))
+        usage(); // Compiling is all it does: later runs on the compiled input can do the rest.
+    where_t where = {0};
+    if (wherePattern != NULL)
+    {
+        where.prefix = wherePattern[0] == '^'; // "^" means "at the start of the line", like in grep.
+        where.text = (const unsigned char *)wherePattern + where.prefix;
+        where.length = strlen((const char *)where.text);
+        // Something to look for, on one line, and not where scan_batch(), scan_groups(), the compiler or the
+        // cache would have to know about it.
+        if (where.length == 0 || memchr(where.text, '\n', where.length) != NULL || batch || grouped ||
+            compileOutput != NULL || cachePath != NULL)
+            usage();
+    }
+    if (cachePath != NULL && (batch || grouped || ranked || wordsPath != NULL || compileOutput != NULL))
+        usage(); // The cache only keeps each chunk's sum, so it can't say anything about groups or lines.
+    if (tee && (batch || compileOutput != NULL || cachePath != NULL))
+        usage(); // Passing the input through needs the pipeline, which reads one input, a block at a time.
+    if (fanIn && (grouped || ranked || compileOutput != NULL || cachePath != NULL || tee || io != NULL))
+        usage(); // Each file only has a sum, and they're all read as they come, like pipes.
+    if (deadline != 0 && (batch || compileOutput != NULL || cachePath != NULL || tee))
+        usage(); // The deadline is checked by the pipeline, and the results have to be for a part of one input.
+    if (aggregatePath != NULL && (batch || fanIn || compileOutput != NULL || deadline != 0))
+        usage(); // One sum, for the whole of one input.
+    path = pathCount == 1 ? paths[0] : NULL;
+    if (aggregateRead != NULL) // Print the totals that other trebuchets added up with --aggregate-into. That's all we do.
+    {
+        if (pathCount > 0 || batch || fanIn || tee || watch != 0 || aggregatePath != NULL)
+            usage();
+        aoc_totals_t totals;
+        const char *error = aoc_aggregate_read(aggregateRead, &totals);
+        if (error != NULL)
+        {
+            (void)fprintf(stderr, "%s: %s", error, aggregateRead);
+            exit(EXIT_FAILURE);
+        }
+        (void)printf("%llu runs, %llu lines, %llu bytes\nSum = %lld\n", totals.runs, totals.lines, totals.bytes, totals.sum);
+        return EXIT_SUCCESS;
+    }
+    if (watch != 0) // Show how another trebuchet, run with --progress, is getting on. That's all we do.
+    {
+        if (pathCount > 0 || batch || fanIn || tee || deadline != 0 || watch > LONG_MAX)
+            usage();
+        const char *error = aoc_progress_watch((long)watch, 1); // 1: standard output.
+        if (error != NULL)
+        {
+            (void)fprintf(stderr, "%s: %zu\n", error, watch);
+            exit(EXIT_FAILURE);
+        }
+        return EXIT_SUCCESS;
+    }
+    if (blockSize != 0 && blockSize < 16) // The first block has to be big enough to hold a BOM.
         usage();
 
-    // Open the file used for reading.
-    FILE *f = NULL; // declare f to be NULL in case neither conditions are true, somehow.
-    if (argc < 2)   // If you passed in no arguments, use stdin for input.
+    /*
+        Work out how many threads to use, and how much memory, from what we're allowed (see aoc_limits_t),
+        and which CPUs to pin them to, from how the CPUs share their caches (see aoc_placement_t).
+        --threads, --block-size and --cpus override that.
+    */
+    aoc_limits_t limits;
+    aoc_limits_read(&limits);
+    const char *error;
+    aoc_placement_t placement;
+    if (cpuList == NULL)
+        aoc_placement_read(&placement);
+    else if ((error = aoc_placement_parse(&placement, cpuList)) != NULL)
     {
-        f = stdin;
-        printf("Reading from stdin... (press ^C to exit).");
+        (void)fprintf(stderr, "%s: --cpus %s\n", error, cpuList);
+        exit(EXIT_FAILURE);
+    }
+    aoc_pipeline_t pipeline;
+    aoc_pipeline_size(&pipeline, &limits);
+    if (placement.count > 0 && placement.count < pipeline.workers) // A CPU each, at most.
+    {
+        pipeline.workers = placement.count;
+        pipeline.depth = 2 * placement.count;
     }
-    else if (!(f = fopen(argv[1], "r"))) // Open the file passed in as an argument for reading.
+    pipeline.placement = &placement;
+    if (threads != 0)
+    {
+        pipeline.workers = threads < 1024 ? (unsigned)threads : 1024;
+        pipeline.depth = 2 * pipeline.workers;
+    }
+    if (blockSize != 0)
+        pipeline.blockSize = blockSize;
+
+    // --deadline's clock starts now, so it covers loading the vocabulary too: everything but starting up.
+    unsigned long long started = aoc_now_ns();
+    if (deadline != 0)
+        pipeline.deadline = started + (deadline < ULLONG_MAX / 2000000 ? deadline * 1000000ull : ULLONG_MAX / 2);
+
+    /*
+        --background is for huge inputs on a computer that's busy with more important things: see aoc_background().
+        Pages we've scanned are dropped from the page cache, so other programs' files stay in it. --rate keeps
+        us from hogging the disk and memory bandwidth too.
+    */
+    if (background && (error = aoc_background()) != NULL)
+        (void)fprintf(stderr, "%s: carrying on at normal priority\n", error);
+    pipeline.dropCache = background;
+    pipeline.rate = rate;
+
+    // --io chooses how to read the file, instead of letting the pipeline check how much of it is cached (see aoc_io_t).
+    static const char *const IoNames[] = {"auto", "map", "read", "direct"};
+    for (aoc_io_t i = AocIoAuto; io != NULL && i <= AocIoDirect; i++)
+        if (strcmp(io, IoNames[i]) == 0)
+            pipeline.io = i;
+    if (io != NULL && strcmp(io, IoNames[pipeline.io]) != 0)
+        usage();
+
+    // Time each phase, for --stats. Timing is cheap (a few nanoseconds per call), so we always do it.
+    aoc_timer_t timer;
+    aoc_timer_start(&timer);
+
+    words_t words;
+    if (wordsPath != NULL) // Load the vocabulary before the input, so a typo in it is reported right away.
+    {
+        load_words(wordsPath, &words);
+        aoc_timer_phase(&timer, "vocabulary");
+    }
+
+    if (batch)
     {
-        (void)fprintf(stderr, "Unable to open file: %s", argv[1]);
+        scan_state_t options;
+        scan_init(&options);
+        options.strict = strict;
+        options.maxLineLength = maxLineLength;
+        options.words = wordsPath != NULL ? &words : spelled ? &EnglishWords : NULL;
+        int status = run_batch(paths, pathCount, &options);
+        aoc_timer_phase(&timer, "batch");
+        if (stats)
+            aoc_timer_print(&timer, stderr, 0);
+        return status;
+    }
+    if (fanIn)
+    {
+        scan_state_t options;
+        scan_init(&options);
+        options.strict = strict;
+        options.maxLineLength = maxLineLength;
+        options.words = wordsPath != NULL ? &words : spelled ? &EnglishWords : NULL;
+        options.where = wherePattern != NULL ? &where : NULL;
+        int status = run_fan_in(paths, pathCount, &options, &pipeline, started);
+        aoc_timer_phase(&timer, "fan-in");
+        if (stats)
+        {
+            aoc_timer_print(&timer, stderr, pipeline.bytes);
+            (void)fprintf(stderr, "%-12s %u workers, %u blocks of %zu bytes in flight, %zu inputs (%llu blocks)\n", "fan-in",
+                          pipeline.workers, pipeline.depth, pipeline.blockSize, pathCount, pipeline.blocks);
+        }
+        return status;
+    }
+
+    /*
+        Where the results go: standard output, unless the input is going there (--tee), or --report says where.
+        Errors and --stats always go to standard error.
+    */
+    FILE *report = tee ? stderr : stdout;
+    if (reportPath != NULL && (report = fopen(reportPath, "w")) == NULL)
+    {
+        (void)fprintf(stderr, "Unable to create file: %s", reportPath);
         exit(EXIT_FAILURE);
     }
 
-    // Note on assert(): it only happens when the program is built in debug mode.
-    // So this cannot be relied on for run-time error checking.
-    // It's just to help catch unexpected circumstances during debugging.
-    assert(f != NULL); // This shouldn't occur during runtime at all, 'f' must be non-NULL.
+    if (path == NULL && !tee) // If you passed in no file, use stdin for input.
+        printf("Reading from stdin... (press ^C to exit).");
+
+    scan_state_t state;
+    scan_init(&state);
+    state.strict = strict;
+    state.maxLineLength = maxLineLength;
+    if (wordsPath != NULL)
+        state.words = &words;
+    else if (spelled)
+        state.words = &EnglishWords; // Built into the program, see gen_tables.c.
+    if (wherePattern != NULL)
+        state.where = &where;
+    groups_t groups;
+    if (grouped)
+    {
+        groups_init(&groups, groupDelimiter, groupPrefix);
+        state.groups = &groups;
+    }
+    outliers_t outliers;
+    if (ranked)
+    {
+        if (!outliers_init(&outliers, ranks))
+        {
+            (void)fprintf(stderr, "Out of memory");
+            exit(EXIT_FAILURE);
+        }
+        state.outliers = &outliers;
+    }
 
-    char calibration[3] = {0};    // String containing leftmost and rightmost digits for this line.
-                                  // We initialize it to all 0s, so that way there's a null-terminator at the end.
-                                  // Otherwise, atoi() later on would possibly read past the end of the array.
-    seen_t digitsSeen = SeenZero; // Number of digits seen this line.
-    int sum = 0,                  // Running sum of the values.
-        tmp,                      // Storage for temporary integers.
-        c;                        // Current character being processed.
-    while ((c = fgetc(f)))        // Loop through each character in the file.
+    /*
+        With more than one thread, the input goes through a pipeline (see parallel.c): it's read a block at a
+        time while the blocks before it are being scanned, instead of loading all of it first. --background
+        and --rate need it too, since they work a block at a time, and so does --io.
+    */
+    status_t status;
+    aoc_input_t input = {0};
+    unsigned long long bytes;
+    bool piped = pipeline.workers > 1 || background || rate != 0 || io != NULL || shareProgress;
+    bool compiled = path != NULL && compiled_file(path); // Only regular files are checked here, see compiled_file().
+    if (compileOutput != NULL || compiled) // Compiled inputs are small: just load them.
+        piped = false;
+    if (cachePath != NULL) // Chunks go by content, not by block, so the input is loaded whole.
+        piped = false;
+    if (tee && compiled)
     {
-        // Neither assert() is executed in "Release" builds.
-        assert(digitsSeen >= SeenZero || digitsSeen <= SeenTwo);
-        assert(sum >= 0);
+        (void)fprintf(stderr, "Compiled inputs can't be passed through with --tee: %s", path);
+        exit(EXIT_FAILURE);
+    }
+    if (tee) // The pipeline reads the input a block at a time, and passes each one on as it goes.
+        piped = true;
+    if (deadline != 0 && !compiled) // It checks the clock before each block, too.
+        piped = true; // (Compiled inputs are summed long before any deadline.)
+    pipeline.tee = tee;
+    chunk_cache_t cache = {0};
+    if (cachePath != NULL)
+    {
+        if ((error = cache_load(&cache, cachePath)) != NULL)
+        {
+            (void)fprintf(stderr, "%s: %s", error, cachePath);
+            exit(EXIT_FAILURE);
+        }
+        aoc_timer_phase(&timer, "cache");
+    }
 
-        if (c == '\n' || c == EOF) // If we're at the end of a line, sum the values up.
+    /*
+        The pipeline keeps count of how far it's got, so `kill -USR1 PID` can print it. With --progress, the count
+        is kept in shared memory, for `trebuchet --watch PID` to print as well. See aoc_progress_t.
+    */
+    static aoc_progress_t progressHere;
+    aoc_progress_t *progress = &progressHere;
+    if (piped && shareProgress)
+    {
+        if ((error = aoc_progress_share(&progress)) != NULL)
+            (void)fprintf(stderr, "%s: carrying on without it\n", error);
+        else
         {
-            if (digitsSeen == SeenOne) // If we've seen only one digit, then the left and right digits are the same.
-            {
-                calibration[1] = calibration[0];
-                digitsSeen = SeenTwo; // We've now "seen" two digits, which is checked in the next if-statement.
-            }
-            if (digitsSeen == SeenTwo) // If we've seen two digits, then convert to an integer and sum.
-            {
-                // Figure out if adding sum+tmp would overflow the maximum value of an integer.
-                tmp = atoi(calibration);
-                assert(tmp >= 0); // Should not occur at runtime.
-                if (tmp > INT_MAX - sum)
-                {
-                    (void)fprintf(stderr, "INTEGER OVERFLOW: %d + %d > %d", sum, tmp, INT_MAX);
-                    exit(EXIT_FAILURE);
-                }
-                else
-                    sum += atoi(calibration);
-            }
-            digitsSeen = SeenZero; // Reset number of digits seen.
+            SharedProgress = progress;
+            (void)atexit(remove_progress); // Every exit() below runs it, as well as returning from main().
         }
-        if (c == EOF) // EOF means there's no more file to read.
-            break;
-        if (!isdigit(c)) // If the current character isn't a digit, then skip this loop iteration.
-            continue;
-        if (digitsSeen == SeenZero) // If we haven't seen anything, this is the first character this line.
+    }
+    if (piped)
+        aoc_progress_signal(progress);
+    pipeline.progress = progress;
+    if (piped)
+    {
+        if ((error = scan_pipeline(&state, &pipeline, path, &status)) != NULL)
         {
-            digitsSeen = SeenOne;
-            calibration[0] = c;
+            (void)fprintf(stderr, "%s: %s", error, path ? path : "stdin");
+            exit(EXIT_FAILURE);
         }
-        // If we've seen one character, this is the second character.
-        // If we've seen two characters, this is currently the rightmost character.
+        aoc_timer_phase(&timer, "scan");
+        bytes = pipeline.bytes;
+    }
+    else
+    {
+        /*
+            Load the entire input into memory, which lets the scanner look at many bytes at once,
+            instead of asking for one character at a time with fgetc().
+
+            aoc_input_load() maps files straight into memory when it can, and otherwise reads them in
+            "binary" mode, so the bytes we get are exactly the bytes in the file. In "text" mode, Windows
+            would turn "\r\n" into "\n" for us, which sounds helpful, but it also mangles UTF-16 text
+            (where a newline is the two bytes 0A 00). The scanner ignores '\r' anyway.
+        */
+        error = aoc_input_load(&input, path);
+        if (error != NULL)
+        {
+            (void)fprintf(stderr, "%s: %s", error, path ? path : "stdin");
+            exit(EXIT_FAILURE);
+        }
+        aoc_timer_phase(&timer, "load");
+
+        // Scan the input. scan_input() figures out the encoding from the Byte Order Mark (if there is one).
+        if (compileOutput != NULL)
+            status = compile(&state, &input, compileOutput);
+        else if (compiled_detect(input.data, input.length))
+            status = scan_compiled_input(&state, &input, path, grouped, wordsPath != NULL);
+        else if (cachePath != NULL)
+            status = scan_cached(&state, input.data, input.length, &cache);
         else
+            status = scan_input(&state, input.data, input.length);
+        aoc_timer_phase(&timer, "scan");
+        bytes = input.length;
+    }
+    if (status == StatusOverflow)
+    {
+        (void)fprintf(stderr, "INTEGER OVERFLOW: %d + %d > %d", state.sum, state.overflowValue, INT_MAX);
+        exit(EXIT_FAILURE);
+    }
+    if (status == StatusUnsupported || status == StatusNoMemory || status == StatusGroupEncoding || status == StatusDamaged ||
+        status == StatusWhereEncoding || status == StatusCompiled)
+    {
+        (void)fprintf(stderr, "%s: %s\n", path ? path : "stdin", status_message(status));
+        exit(EXIT_FAILURE);
+    }
+    if (status != StatusOk) // Only strict mode gets here.
+    {
+        (void)fprintf(stderr, "%s: %s at line %llu, byte offset %llu\n",
+                      path ? path : "stdin", status_message(status), state.lines + 1, state.errorOffset);
+        exit(EXIT_FAILURE);
+    }
+    if (stats) // On stderr, so the answer on stdout stays easy to read with another program.
+    {
+        aoc_timer_print(&timer, stderr, bytes);
+        aoc_limits_print(&limits, stderr);
+        if (piped)
+        {
+            static const char *const KindNames[] = {"read", "mapped", "read directly"};
+            (void)fprintf(stderr, "%-12s %u workers, %u blocks of %zu bytes in flight, %s (%llu blocks)\n", "pipeline",
+                          pipeline.workers, pipeline.depth, pipeline.blockSize, KindNames[pipeline.kind], pipeline.blocks);
+            if (pipeline.sampled > 0)
+                (void)fprintf(stderr, "%-12s %u of %u sampled pages were cached\n", "page cache", pipeline.resident,
+                              pipeline.sampled);
+            aoc_placement_print(&placement, stderr);
+            (void)fflush(stderr); // aoc_progress_write() writes to the file descriptor, around stderr's buffer.
+            aoc_progress_write(progress, 2);
+            if (rate != 0)
+                (void)fprintf(stderr, "%-12s %zu bytes/s, waited %.3f ms\n", "rate", rate, (double)pipeline.waited / 1e6);
+        }
+        if (tee)
+            (void)fprintf(stderr, "%-12s copied with %s\n", "tee", pipeline.zeroCopy ? "tee() and splice()" : "write()");
+        if (cachePath != NULL)
+            (void)fprintf(stderr, "%-12s %llu of %llu chunks were cached (%llu of %llu bytes)\n", "cache", cache.hits,
+                          cache.hits + cache.misses, cache.hitBytes, cache.bytes);
+    }
+    if (cachePath != NULL) // Only after a successful scan: a failed one has exited above, leaving the file as it was.
+    {
+        if ((error = cache_save(&cache, cachePath)) != NULL)
+            (void)fprintf(stderr, "%s: %s (the sum is still right)\n", error, cachePath);
+        cache_free(&cache);
+    }
+    if (input.data != NULL)
+        aoc_input_free(&input); // not really needed, the OS cleans up when we exit
+    if (wordsPath != NULL)
+        words_free(&words);
+    if (compileOutput != NULL)
+    {
+        (void)printf("Compiled %llu lines into %s\n", state.lines, compileOutput);
+        return EXIT_SUCCESS;
+    }
+    if (pipeline.expired)
+        print_deadline(report, started, pipeline.bytes, state.lines);
+    if (ranked)
+    {
+        print_outliers(report, &outliers);
+        outliers_free(&outliers);
+    }
+    if (grouped) // Each group's sum fits in a 'long long', even where the total of them all wouldn't fit in an 'int'.
+    {
+        const group_t **sorted = groups_sorted(&groups);
+        if (sorted == NULL)
         {
-            digitsSeen = SeenTwo; // Since this is inside an "else" block, we explicitly set to SeenTwo from SeenOne.
-            calibration[1] = c;
+            (void)fprintf(stderr, "Out of memory");
+            exit(EXIT_FAILURE);
         }
+        long long total = 0;
+        for (size_t i = 0; i < groups.count; i++)
+        {
+            (void)fprintf(report, "%.*s: Sum = %lld\n", (int)sorted[i]->length, sorted[i]->tag, sorted[i]->sum);
+            total += sorted[i]->sum;
+        }
+        free(sorted);
+        groups_free(&groups);
+        aggregate(aggregatePath, bytes, state.lines, total);
+        (void)fprintf(report, "Sum = %lld\n", total);
+        return close_report(report, reportPath, pipeline.expired ? EXIT_DEADLINE : EXIT_SUCCESS);
     }
-    (void)fclose(f); // not really needed, OS will clean up the file when we exit
-    (void)printf("Sum = %d\n", sum);
+    aggregate(aggregatePath, bytes, state.lines, state.sum);
+    (void)fprintf(report, "Sum = %d\n", state.sum);
 
-    return EXIT_SUCCESS; // Success status code.
+    return close_report(report, reportPath, pipeline.expired ? EXIT_DEADLINE : EXIT_SUCCESS);
 }
 
 /* Misc info: Encoding
 
-We ignore non-ASCII encodings with how we're processing strings here.
+We mostly ignore non-ASCII encodings with how we're processing strings here.
 
 ASCII is a way of assigning a number to each character. Internally, computers store
 the number and "know" that the number corresponds to a letter. For example, the number "104" is the letter 'h' in ASCII.
@@ -195,6 +897,20 @@ depending on where it's used in the entire input.
 
 Making this code portable for all kinds of text formats would require more thought.
 
+We handle one common case: files that start with a Byte Order Mark (BOM). Windows programs often write
+UTF-16LE text with the BOM FF FE, where every character takes (at least) two bytes. detect_encoding() in
+trebuchet.c spots the BOM, and scan_utf16le() looks for digits and newlines in whole 16-bit units.
+That saves converting the file with a tool like iconv first, which would read and write everything twice.
+
+See: https://en.wikipedia.org/wiki/UTF-16
+See: https://en.wikipedia.org/wiki/Iconv
+
+Digits aren't only '0' to '9', either. Arabic-Indic '٣', Devanagari '३' and fullwidth '３' are all the digit three.
+The scanner decodes multi-byte characters and looks them up with unicode_digit(). Decoding is slower than
+comparing bytes, so it only happens for blocks of the input that actually contain non-ASCII bytes.
+
+See: https://en.wikipedia.org/wiki/Numerals_in_Unicode
+
 Here are some helpful resources about string encoding:
 
     https://en.wikipedia.org/wiki/Character_encoding
@@ -203,6 +919,100 @@ Here are some helpful resources about string encoding:
     https://docs.python.org/3/howto/unicode.html
 */
 
+/* Misc info: Spelled-out digits
+
+Part two of the puzzle says that words like "one" count as digits too. Rather than hard-code the English
+words, --words loads them from a file, so "eins 1" or "uno 1" work just as well. english.words and
+multilingual.words in this folder are examples. --spelled uses english.words, which is built into the
+program while compiling (see gen_tables.c), so there's no file to read.
+
+The tricky part is that words can overlap: "twone" has both "two" and "one" in it, sharing the 'o'.
+A simple approach would check every word at every position, but then each extra word (or language) makes
+the program slower. Instead, words.c compiles the vocabulary into an Aho-Corasick automaton: a table that
+the scanner follows with exactly one lookup per byte, no matter how many words there are. Overlaps come
+for free, since the automaton reports every word that ends at each byte.
+
+See: https://adventofcode.com/2023/day/1#part2
+See: https://en.wikipedia.org/wiki/Aho%E2%80%93Corasick_algorithm
+*/
+
+/* Misc info: Strict mode
+
+By default, the scanner is forgiving: it skips over anything it doesn't understand. That's convenient,
+but it means a corrupted file quietly produces a wrong answer.
+
+With --strict, the program stops at the first problem and tells you the byte offset, so you can jump
+right to it in a hex editor. It rejects:
+
+    * bytes that aren't valid UTF-8 (or unpaired surrogates in UTF-16),
+    * NUL bytes and other control characters (tab, carriage return and newline are fine),
+    * lines longer than --max-line-length bytes (4096 unless you say otherwise).
+
+A common way to validate input is to read it once to check it, then again to process it. Instead,
+the checks are folded into the same SIMD loop that looks for digits. Plain ASCII text is always valid
+UTF-8, so for most blocks strict mode only adds a few comparisons looking for control characters.
+
+See: https://en.wikipedia.org/wiki/UTF-8#Invalid_sequences_and_error_handling
+See: https://github.com/simdutf/simdutf (a library that validates text this way, much more cleverly)
+*/
+
+/* Misc info: Compiled inputs
+
+If you scan the same big input again and again (with and without --spelled, say), most of the work each
+time is finding the same digits in the same text. --compile-input does it once, and writes what it found
+to a file: for each line, its first and last digit in a byte (and again with spelled-out digits), plus its
+length. That's about 3 bytes for a line whose text took 30 or 40.
+
+Run trebuchet on that file like you would on the text, and it notices (from the file's first few bytes)
+and adds up the bytes instead. It gives the same answers, the same errors for an overflowing sum, and
+the same offsets for --top and friends. Reading 1 byte a line instead of 30 or 40 is where the speed comes
+from: it's a "memory bandwidth" problem now, with nothing left to decode. compiled.c has the details.
+
+Things the compiled file doesn't keep can't be done with it: --group-delim needs the tags, --words needs
+the letters, and --strict needs the text to have passed --strict when it was compiled.
+
+See: https://en.wikipedia.org/wiki/Memory_bandwidth
+*/
+
+/* Misc info: The chunk cache
+
+With --cache, trebuchet cuts the input into chunks of about 64 KiB, and saves each chunk's sum in the cache
+file, under a hash of its bytes. Next time, a chunk whose bytes are the same is looked up instead of
+scanned. The trick is where the cuts go: at places the bytes themselves pick (see cache.c), not every
+64 KiB. Editing one line only changes the chunk (or two) around it, and the rest are cut just like last
+time, so they're all found in the cache.
+
+The cache remembers which options (--strict, --max-line-length, --spelled) each chunk was scanned with,
+and keeps the chunks from the last run with each. It's written to a new file, which then replaces the old
+one, so an interrupted run leaves the old cache as it was.
+
+Compiled inputs (above) are faster still, but have to be compiled again after every edit.
+
+See: https://en.wikipedia.org/wiki/Rolling_hash
+*/
+
+/* Misc info: Fan-in
+
+When several programs each write lines as they go, give each one a FIFO (a "named pipe") to write into:
+
+    mkfifo oven.fifo mill.fifo
+    oven-logger > oven.fifo &
+    mill-logger > mill.fifo &
+    trebuchet --fan-in oven.fifo mill.fifo
+
+One trebuchet per FIFO would work too, but each would start threads of its own, and add up its own sum.
+With --fan-in, one reading thread waits on every FIFO at once with epoll, and reads whichever have lines
+waiting, so a quiet program doesn't hold up a busy one, and the same worker threads scan all of them.
+
+A program may write half a line, and the rest later. So each FIFO's bytes wait in a buffer of their own
+until there's a block of whole lines, which is only ever that FIFO's lines. A FIFO is finished when its
+program closes it, and regular files can be named too, which are simply read. If any input fails, the
+others are still scanned and printed, but there's no total.
+
+See: https://man7.org/linux/man-pages/man3/mkfifo.3.html
+See: https://man7.org/linux/man-pages/man7/epoll.7.html
+*/
+
 /* Misc info: Testing
 
 The test cases that are included with the CMakeTests.txt are not really a good indication that this program works properly.
@@ -231,6 +1041,7 @@ is amalgamated into a single loop.
 Breaking this into separate functions would improve its testability. For example, a function `bool would_overflow(int a, int b)`
 would let us test the implementation of overflow detection independently from the rest of the code. We could directly pass it input
 from a test suite, rather than writing a script or creating a massive input file with 21,691,754 lines where each line is just '9'.
+overflow_check.c does something like that: the scanner can start from any sum, so it starts near INT_MAX, and a few lines overflow.
 
 There's even a paradigm called Test Driven Development, where you take your requirements and write the test-cases *first*. Then you
 implement code to pass those test cases. This is hugely useful for code in a big company that has a ton of legacy components. You
@@ -0,0 +1,140 @@
+// This file keeps the lines that stand out, for outliers_t in outlier.h.
+
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+
+#include "outlier.h"
+
+bool outliers_init(outliers_t *outliers, const size_t limits[RankCount])
+{
+    *outliers = (outliers_t){0};
+    for (int rank = 0; rank < RankCount; rank++)
+    {
+        outliers->limit[rank] = limits[rank];
+        if (limits[rank] == 0)
+            continue;
+        outliers->lines[rank] = calloc(limits[rank], sizeof(outlier_line_t));
+        if (outliers->lines[rank] == NULL)
+        {
+            outliers_free(outliers);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether line 'a' ranks ahead of line 'b'. Offsets are never equal, so one of them always does.
+static bool ahead(rank_t rank, const outlier_line_t *a, const outlier_line_t *b)
+{
+    switch (rank)
+    {
+    case RankTop:
+        if (a->value != b->value)
+            return a->value > b->value;
+        break;
+    case RankBottom:
+        if (a->value != b->value)
+            return a->value < b->value;
+        break;
+    case RankLongest:
+        if (a->length != b->length)
+            return a->length > b->length;
+        break;
+    default: // RankNoDigits: the earliest lines, so just the offsets.
+        break;
+    }
+    return a->offset < b->offset;
+}
+
+/*
+    Move the line at 'heap[i]' down the heap, until it's ahead of the lines below it. A line's "children" are at
+    2i + 1 and 2i + 2, and each is behind it (or the same), so the line that ranks last ends up at [0].
+*/
+static void sift_down(rank_t rank, outlier_line_t *heap, size_t count, size_t i)
+{
+    outlier_line_t line = heap[i];
+    for (;;)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= count)
+            break;
+        if (child + 1 < count && ahead(rank, &heap[child], &heap[child + 1])) // Follow the child that's further behind.
+            child++;
+        if (!ahead(rank, &line, &heap[child]))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = line;
+}
+
+// Offer 'line' to one ranking: it gets in if there's room, or if it's ahead of the line that ranks last.
+static void offer(outliers_t *outliers, rank_t rank, const outlier_line_t *line)
+{
+    outlier_line_t *heap = outliers->lines[rank];
+    size_t count = outliers->count[rank];
+    if (count < outliers->limit[rank]) // There's room: add it at the bottom, and move it up past anything ahead of it.
+    {
+        size_t i = count;
+        while (i > 0 && ahead(rank, &heap[(i - 1) / 2], line))
+        {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *line;
+        outliers->count[rank] = count + 1;
+    }
+    else if (count > 0 && ahead(rank, line, &heap[0])) // It beats the last one, which it replaces.
+    {
+        heap[0] = *line;
+        sift_down(rank, heap, count, 0);
+    }
+}
+
+void outliers_add(outliers_t *outliers, unsigned long long offset, unsigned long long length, int value)
+{
+    outlier_line_t line = {offset, length, value};
+    if (value >= 0)
+    {
+        offer(outliers, RankTop, &line);
+        offer(outliers, RankBottom, &line);
+    }
+    else
+        offer(outliers, RankNoDigits, &line);
+    offer(outliers, RankLongest, &line);
+}
+
+void outliers_merge(outliers_t *into, const outliers_t *from)
+{
+    for (int rank = 0; rank < RankCount; rank++)
+        for (size_t i = 0; i < from->count[rank]; i++)
+            offer(into, (rank_t)rank, &from->lines[rank][i]);
+}
+
+void outliers_sort(outliers_t *outliers, rank_t rank)
+{
+    /*
+        Heapsort: swap the line that ranks last to the end, and fix the heap for the lines before it. Repeat,
+        and the lines fill the array from the end backwards, from the last to the best.
+
+        See: https://en.wikipedia.org/wiki/Heapsort
+    */
+    outlier_line_t *heap = outliers->lines[rank];
+    for (size_t count = outliers->count[rank]; count > 1; count--)
+    {
+        outlier_line_t last = heap[0];
+        heap[0] = heap[count - 1];
+        heap[count - 1] = last;
+        sift_down(rank, heap, count - 1, 0);
+    }
+}
+
+void outliers_free(outliers_t *outliers)
+{
+    for (int rank = 0; rank < RankCount; rank++)
+    {
+        free(outliers->lines[rank]);
+        outliers->lines[rank] = NULL;
+        outliers->count[rank] = 0;
+    }
+}
@@ -0,0 +1,65 @@
+// This file declares "outliers": the few lines that stand out, like the ones with the highest values,
+// for debugging an input that gives a surprising sum.
+//
+// The scanner adds every line as it finishes it (see end_line() in trebuchet.c), and outlier.c keeps the best few.
+
+#ifndef OUTLIER_H
+#define OUTLIER_H
+
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+
+// One line, as the outliers remember it: where it is, rather than what's in it, which may be long gone.
+typedef struct OUTLIER_LINE
+{
+    unsigned long long offset; // Where the line starts, counted like the offsets in scan_state_t.
+    unsigned long long length; // How many bytes it has, without the newline.
+    int value;                 // Its calibration value, or -1 if it has no digits.
+} outlier_line_t;
+
+// The ways to rank lines. Lines that tie are ranked by offset, so the earliest comes first.
+typedef enum RANK
+{
+    RankTop,      // The highest values (lines with digits only).
+    RankBottom,   // The lowest values (lines with digits only).
+    RankNoDigits, // The first lines with no digits at all.
+    RankLongest,  // The longest lines.
+    RankCount     // How many rankings there are.
+} rank_t;
+
+/*
+    The best few lines for each ranking.
+
+    Each ranking keeps at most 'limit' lines in a "heap": an array that's ordered just enough that the line
+    that ranks last is always at [0]. A new line only has to beat that one to get in, which is one comparison
+    for nearly every line of a big input. Getting in costs log2(limit) swaps to put the array back in order.
+    However long the input, the memory used is the same.
+
+    See: https://en.wikipedia.org/wiki/Binary_heap
+    See: https://en.wikipedia.org/wiki/Partial_sorting
+*/
+typedef struct OUTLIERS
+{
+    size_t limit[RankCount];          // How many lines to keep for each ranking (0: that ranking is off).
+    size_t count[RankCount];          // How many lines each ranking has so far.
+    outlier_line_t *lines[RankCount]; // Each ranking's heap, with room for 'limit' lines.
+} outliers_t;
+
+// Start with no lines, keeping up to limits[rank] for each ranking. Returns false if there's no memory.
+bool outliers_init(outliers_t *outliers, const size_t limits[RankCount]);
+
+// Offer a line to every ranking. 'value' is -1 if the line has no digits.
+void outliers_add(outliers_t *outliers, unsigned long long offset, unsigned long long length, int value);
+
+// Offer every line in 'from' to 'into', which must have the same limits.
+void outliers_merge(outliers_t *into, const outliers_t *from);
+
+// Sort the lines of 'rank', best first, for printing. It's no longer a heap afterwards, so add no more lines.
+void outliers_sort(outliers_t *outliers, rank_t rank);
+
+// Free the memory used by 'outliers'.
+void outliers_free(outliers_t *outliers);
+
+#endif // OUTLIER_H
@@ -0,0 +1,111 @@
+// This file is a small program that checks that every way of scanning an input reports the same error, when the
+// sum overflows just before a line that --strict rejects. CMakeLists.txt runs it on overflow01.txt.
+//
+// Reaching INT_MAX the honest way takes an input of about 65 MB (see "Misc info: Testing" in main.c). Every scan
+// carries on from the sum it's given, so this one starts near INT_MAX instead, and a few lines are enough.
+//
+// Execute like so:
+//
+// ./overflow_check START input.txt
+//
+// START is the sum to start from. It scans the input with scan_input(), then on several threads with tiny blocks
+// (scan_pipeline()), with an empty chunk cache (scan_cached()), and with --fan-in (scan_fan_in()), all with
+// --strict, and complains about any that doesn't give the same error as scan_input().
+
+// limits.h used for INT_MAX
+#include <limits.h>
+// stdio.h used for input/output
+#include <stdio.h>
+// stdlib.h used for strtol() and exit codes
+#include <stdlib.h>
+
+#include "trebuchet.h"
+
+// A fresh scan_state_t with --strict, starting from 'sum'.
+static scan_state_t strict_state(int sum)
+{
+    scan_state_t state;
+    scan_init(&state);
+    state.strict = true;
+    state.sum = sum;
+    return state;
+}
+
+// The settings --threads 4 --block-size 16 would pick: lots of blocks, even for a few lines.
+static aoc_pipeline_t tiny_blocks(void)
+{
+    return (aoc_pipeline_t){.workers = 4, .depth = 8, .blockSize = 16};
+}
+
+// Print 'result' the way trebuchet would, and compare it with 'expected'. Returns whether they're the same.
+static bool report(const char *how, const scan_result_t *result, const scan_result_t *expected)
+{
+    if (result->status == StatusOverflow)
+        (void)printf("%-12s %s: %d + %d > %d, after %llu lines\n", how, status_message(result->status), result->sum,
+                     result->overflowValue, INT_MAX, result->lines);
+    else
+        (void)printf("%-12s %s at line %llu, byte offset %llu\n", how, status_message(result->status),
+                     result->lines + 1, result->errorOffset);
+    return result->status == expected->status && result->sum == expected->sum &&
+           result->overflowValue == expected->overflowValue && result->lines == expected->lines &&
+           (result->status == StatusOverflow || result->errorOffset == expected->errorOffset);
+}
+
+// The parts of 'state' that describe its result.
+static scan_result_t result_of(const scan_state_t *state, status_t status)
+{
+    return (scan_result_t){status, state->sum, state->overflowValue, state->lines, state->errorOffset};
+}
+
+int main(int argc, char **argv)
+{
+    char *end;
+    long start = argc == 3 ? strtol(argv[1], &end, 10) : -1;
+    if (argc != 3 || *end != '\0' || start < 0 || start > INT_MAX)
+    {
+        (void)fprintf(stderr, "Usage: %s START INPUT\n", argv[0] != NULL ? argv[0] : "overflow_check");
+        return EXIT_FAILURE;
+    }
+    const char *path = argv[2];
+    aoc_input_t input;
+    const char *error = aoc_input_load(&input, path);
+    if (error != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s\n", error, path);
+        return EXIT_FAILURE;
+    }
+
+    scan_state_t state = strict_state((int)start);
+    scan_result_t expected = result_of(&state, scan_input(&state, input.data, input.length));
+    bool same = report("scan_input", &expected, &expected);
+
+    state = strict_state((int)start);
+    aoc_pipeline_t pipeline = tiny_blocks();
+    status_t status;
+    if ((error = scan_pipeline(&state, &pipeline, path, &status)) != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s\n", error, path);
+        return EXIT_FAILURE;
+    }
+    scan_result_t result = result_of(&state, status);
+    same &= report("pipeline", &result, &expected);
+
+    state = strict_state((int)start);
+    chunk_cache_t cache = {0}; // Empty, so every chunk is scanned.
+    result = result_of(&state, scan_cached(&state, input.data, input.length, &cache));
+    same &= report("cached", &result, &expected);
+    cache_free(&cache);
+
+    state = strict_state((int)start);
+    pipeline = tiny_blocks();
+    if ((error = scan_fan_in(&state, &pipeline, &path, 1, &result)) != NULL)
+    {
+        (void)fprintf(stderr, "%s: %s\n", error, path);
+        return EXIT_FAILURE;
+    }
+    same &= report("fan-in", &result, &expected);
+
+    aoc_input_free(&input);
+    (void)printf(same ? "All the same\n" : "Not all the same\n");
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
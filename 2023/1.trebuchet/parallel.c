@@ -0,0 +1,251 @@
+// This file scans an input on several threads at once, for scan_pipeline() and scan_fan_in() in trebuchet.h.
+//
+// Every line's calibration value depends on that line alone, so lines can be scanned in any order,
+// by any thread. aoc_pipeline_run() (in the runtime folder) cuts the input into blocks of whole lines,
+// and gives each block to a worker thread. Each worker scans its block with a scan_state_t of its own.
+// Then the blocks' results are added up in order, so that errors are reported exactly as scan_input()
+// would report them.
+//
+// With groups (see group.h) or outliers (see outlier.h), each worker adds its lines to a table of its own,
+// so the workers never wait for each other, and the tables are merged once at the end.
+//
+// scan_fan_in() scans several inputs at once, each with a result of its own, on the same workers.
+
+// limits.h used for INT_MAX
+#include <limits.h>
+// stdlib.h used for calloc() and free()
+#include <stdlib.h>
+
+#include "trebuchet.h"
+
+// What one worker collects on its own, with groups or outliers.
+typedef struct SCAN_WORKER
+{
+    groups_t groups;
+    outliers_t outliers;
+} scan_worker_t;
+
+// What we know about one input. Only the reading thread writes 'encoding' and 'compiled', before any block that needs them exists.
+typedef struct SCAN_SOURCE
+{
+    encoding_t encoding;         // The input's encoding, found at the start of its first block.
+    bool detected;               // Whether 'encoding' has been set.
+    bool compiled;               // Whether it's a compiled input, which is only read whole (see compiled.h).
+    scan_result_t total;         // The result of every block of it merged so far.
+} scan_source_t;
+
+// What the threads share.
+typedef struct SCAN_PIPELINE
+{
+    const scan_state_t *options; // The options to scan with (strict, maxLineLength, words, where).
+    scan_source_t *sources;      // One for each input: just the one, except with scan_fan_in().
+    bool fanIn;                  // Whether the other inputs carry on after one has an error.
+    unsigned long long lines;    // How many lines have been merged, from every input.
+    long long sum;               // And their sum.
+    aoc_progress_t *progress;    // Where to show the lines and sum so far, or NULL.
+    scan_worker_t *workers;      // With groups or outliers: what each worker collects, or NULL.
+} scan_pipeline_t;
+
+/*
+    Scan one block, starting from 'sum', and store what happened in 'result'. If 'collect' is true, its lines go
+    in the groups and outliers of the worker that took it, too.
+
+    The first block starts with the BOM (if there is one), so it works out the encoding itself. Blocks
+    always start at the start of a line, so a fresh scan_state_t is in exactly the state that a scan of
+    the whole input would be in, once it got there (apart from the sum, which is only needed to find where
+    an overflow happens).
+*/
+static void scan_block(const scan_pipeline_t *shared, const aoc_block_t *block, int sum, bool collect,
+                       scan_result_t *result)
+{
+    scan_state_t state;
+    scan_init(&state);
+    state.strict = shared->options->strict;
+    state.maxLineLength = shared->options->maxLineLength;
+    state.words = shared->options->words;
+    state.where = shared->options->where;
+    state.sum = sum;
+    if (collect && shared->options->groups != NULL)
+        state.groups = &shared->workers[block->worker].groups;
+    if (collect && shared->options->outliers != NULL)
+        state.outliers = &shared->workers[block->worker].outliers;
+
+    const unsigned char *data = block->data;
+    size_t length = block->length, bomLength = 0;
+    encoding_t encoding = block->index == 0 ? detect_encoding(data, length, &bomLength) : shared->sources[block->source].encoding;
+    state.offset = state.lineStart = block->offset + bomLength;
+    status_t status = StatusUnsupported;
+    if (block->index == 0 ? compiled_detect(data, length) : shared->sources[block->source].compiled)
+        status = StatusCompiled; // The first block has the magic number, and split() noted it for the rest.
+    else if (encoding == EncodingUtf8 && state.groups != NULL)
+        status = scan_groups(&state, data + bomLength, length - bomLength);
+    else if (encoding == EncodingUtf8)
+        status = scan_utf8(&state, data + bomLength, length - bomLength);
+    else if (encoding == EncodingUtf16le && state.groups != NULL)
+        status = StatusGroupEncoding;
+    else if (encoding == EncodingUtf16le)
+        status = scan_utf16le(&state, data + bomLength, length - bomLength);
+    if (status == StatusOk)
+        status = scan_finish(&state); // The last block may not end in a newline.
+    *result = (scan_result_t){status, state.sum, state.overflowValue, state.lines, state.errorOffset};
+}
+
+// Find the end of the last whole line in 'data'. Called by the reading thread, on each block in turn.
+static size_t split(void *context, size_t source, const unsigned char *data, size_t length)
+{
+    scan_source_t *input = &((scan_pipeline_t *)context)->sources[source];
+    if (!input->detected) // The first call is on the start of the input, where the BOM is.
+    {
+        size_t bomLength;
+        input->encoding = detect_encoding(data, length, &bomLength);
+        input->compiled = compiled_detect(data, length);
+        input->detected = true;
+    }
+    if (input->compiled) // Every block fails anyway: no need to look for lines.
+        return length;
+    if (input->encoding == EncodingUtf16le)
+    {
+        // A newline is the pair of bytes 0A 00, at an even offset. Blocks start at even offsets, so "even" is the same here.
+        for (size_t i = (length & ~(size_t)1); i >= 2; i -= 2)
+            if (data[i - 2] == '\n' && data[i - 1] == 0)
+                return i;
+        return 0;
+    }
+    if (input->encoding != EncodingUtf8) // Unsupported: the first block will say so, and stop everything.
+        return length;
+    for (size_t i = length; i > 0; i--)
+        if (data[i - 1] == '\n')
+            return i;
+    return 0;
+}
+
+static void work(void *context, aoc_block_t *block)
+{
+    scan_block(context, block, 0, true, block->result);
+}
+
+/*
+    Add one block's result to its input's total. Called for each block of an input in order, so the first error
+    we see is the first error in the input. Line numbers in errors count the lines in the blocks before, too.
+
+    An error stops everything, except with scan_fan_in(), where the other inputs carry on, and the rest of
+    this one is read but left out.
+*/
+static bool merge(void *context, aoc_block_t *block)
+{
+    scan_pipeline_t *shared = context;
+    scan_result_t *total = &shared->sources[block->source].total;
+    scan_result_t *result = block->result;
+    aoc_progress_t *progress = shared->progress;
+    if (total->status != StatusOk)
+        return true;
+    if (result->status == StatusOk && result->sum <= INT_MAX - total->sum)
+    {
+        total->sum += result->sum;
+        total->lines += result->lines;
+        shared->sum += result->sum;
+        shared->lines += result->lines;
+        if (progress != NULL)
+        {
+            atomic_store_explicit(&progress->lines, shared->lines, memory_order_relaxed);
+            atomic_store_explicit(&progress->sum, shared->sum, memory_order_relaxed);
+        }
+        return true;
+    }
+    if (result->status == StatusOverflow || result->sum > INT_MAX - total->sum)
+    {
+        /*
+            The sum overflows somewhere in this block. To report the same numbers as scan_input(), scan the
+            block again, starting from the sum so far. That goes for a block with an error, too: its 'sum' is
+            what came before the error, so if that overflows, the overflow comes first. The block is still in
+            memory until we return. Its lines were already collected (and its worker may be busy with another
+            block), so don't collect them again.
+        */
+        unsigned long long lines = total->lines;
+        scan_block(shared, block, total->sum, false, total);
+        total->lines += lines;
+        return total->status == StatusOk || shared->fanIn;
+    }
+    total->status = result->status;
+    total->lines += result->lines;
+    total->errorOffset = result->errorOffset;
+    return shared->fanIn;
+}
+
+const char *scan_pipeline(scan_state_t *state, aoc_pipeline_t *pipeline, const char *path, status_t *status)
+{
+    scan_source_t source = {.total = {StatusOk, state->sum, 0, 0, 0}}; // Carry on from its sum, like scan_input().
+    scan_pipeline_t shared = {.options = state, .sources = &source, .progress = pipeline->progress};
+    unsigned workers = pipeline->workers;
+    if (state->groups != NULL || state->outliers != NULL)
+    {
+        if (workers == 0) // aoc_pipeline_run() would pick 1.
+            workers = pipeline->workers = 1;
+        shared.workers = calloc(workers, sizeof *shared.workers);
+        if (shared.workers == NULL)
+            return "Unable to allocate worker tables";
+        for (unsigned i = 0; i < workers; i++)
+        {
+            if (state->groups != NULL)
+                groups_init(&shared.workers[i].groups, state->groups->delimiter, state->groups->prefix);
+            if (state->outliers != NULL && !outliers_init(&shared.workers[i].outliers, state->outliers->limit))
+            {
+                while (i-- > 0)
+                    outliers_free(&shared.workers[i].outliers);
+                free(shared.workers);
+                return "Unable to allocate worker tables";
+            }
+        }
+    }
+    pipeline->context = &shared;
+    pipeline->resultSize = sizeof(scan_result_t);
+    pipeline->split = split;
+    pipeline->work = work;
+    pipeline->merge = merge;
+    const char *error = aoc_pipeline_run(pipeline, path);
+    for (unsigned i = 0; shared.workers != NULL && i < workers; i++)
+    {
+        scan_worker_t *worker = &shared.workers[i];
+        if (state->groups != NULL)
+        {
+            if (source.total.status == StatusOk && !groups_merge(state->groups, &worker->groups))
+                source.total.status = StatusNoMemory;
+            groups_free(&worker->groups);
+        }
+        if (state->outliers != NULL)
+        {
+            outliers_merge(state->outliers, &worker->outliers);
+            outliers_free(&worker->outliers);
+        }
+    }
+    free(shared.workers);
+
+    state->sum = source.total.sum;
+    state->overflowValue = source.total.overflowValue;
+    state->lines = source.total.lines;
+    state->errorOffset = source.total.errorOffset;
+    state->offset = pipeline->bytes;
+    *status = source.total.status;
+    return error;
+}
+
+const char *scan_fan_in(const scan_state_t *options, aoc_pipeline_t *pipeline, const char *const *paths, size_t count,
+                        scan_result_t *results)
+{
+    scan_pipeline_t shared = {.options = options, .sources = calloc(count > 0 ? count : 1, sizeof *shared.sources),
+                              .fanIn = true, .progress = pipeline->progress};
+    if (shared.sources == NULL)
+        return "Out of memory";
+    for (size_t i = 0; i < count; i++)
+        shared.sources[i].total.sum = options->sum;
+    pipeline->context = &shared;
+    pipeline->resultSize = sizeof(scan_result_t);
+    pipeline->split = split;
+    pipeline->work = work;
+    pipeline->merge = merge;
+    const char *error = aoc_pipeline_fan_in(pipeline, paths, count);
+    for (size_t i = 0; i < count; i++)
+        results[i] = shared.sources[i].total;
+    free(shared.sources);
+    return error;
+}
@@ -0,0 +1,16 @@
+# This script runs a program with a file on its standard input, like `trebuchet --threads 2 < input.txt`, for
+# the tests in CMakeLists.txt. add_test() can't redirect standard input itself, but execute_process() can.
+#
+# Run it like so: cmake -DPROGRAM=path/to/trebuchet "-DARGS=--threads 2" -DINPUT=input.txt -P run_with_stdin.cmake
+#
+# The program's output is printed for the test to match (standard output, then standard error), and the
+# script fails if the program did, so a test can check that too.
+#
+# See: https://cmake.org/cmake/help/latest/command/execute_process.html
+separate_arguments(args NATIVE_COMMAND "${ARGS}")
+execute_process(COMMAND ${PROGRAM} ${args} INPUT_FILE ${INPUT} OUTPUT_VARIABLE output ERROR_VARIABLE error
+  RESULT_VARIABLE result)
+message("${output}${error}")
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${PROGRAM} exited with ${result}")
+endif()
@@ -0,0 +1,47 @@
+// This file declares lookup tables that are generated while building, by gen_tables.c.
+//
+// The generated file (tables.c) is written into the build folder, not the source folder,
+// so you won't find it next to this header. Build once, then look in the build folder.
+
+#ifndef TABLES_H
+#define TABLES_H
+
+// words.h declares the automaton type used for EnglishWords
+#include "words.h"
+
+/*
+    Bits in ByteClass[]. A byte can have more than one (a NUL byte is BYTE_CONTROL and nothing else,
+    while a newline is BYTE_NEWLINE, but not BYTE_CONTROL, because strict mode allows it).
+
+    Each name is a power of two, so it occupies its own bit, and you test for it with '&'.
+
+    See: https://en.wikipedia.org/wiki/Bit_field
+*/
+#define BYTE_DIGIT 0x01        // '0' to '9'.
+#define BYTE_NEWLINE 0x02      // '\n'.
+#define BYTE_CONTROL 0x04      // An ASCII control character that strict mode rejects (including NUL and DEL).
+#define BYTE_CONTINUATION 0x08 // A UTF-8 continuation byte, 10xxxxxx.
+#define BYTE_LEAD 0x10         // A UTF-8 lead byte, which starts a multi-byte character.
+#define BYTE_INVALID 0x20      // A byte that never appears in valid UTF-8 (C0, C1, F5 to FF).
+
+// How to start decoding a multi-byte UTF-8 character, given its lead byte. See see_byte_utf8() in trebuchet.c.
+typedef struct UTF8_LEAD
+{
+    unsigned char pending;      // How many continuation bytes follow (0 if this isn't a lead byte).
+    unsigned char mask;         // Which bits of the lead byte belong to the character.
+    unsigned char lower, upper; // The range of the first continuation byte.
+} utf8_lead_t;
+
+/*
+    'extern' declares a variable without defining it: it says "this exists, in some other file".
+    The definitions are in the generated tables.c.
+
+    See: https://en.cppreference.com/w/c/language/storage_duration
+*/
+extern const unsigned char ByteClass[256];
+extern const utf8_lead_t Utf8Lead[256];
+
+// The automaton for english.words, ready to use without building anything at startup.
+extern const words_t EnglishWords;
+
+#endif // TABLES_H
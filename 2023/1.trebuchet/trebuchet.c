@@ -0,0 +1,792 @@
+// This file contains the scanner for the Day 1 Advent of Code challenge.
+//
+// It is the part of the solution that looks at every byte of the input, so it is
+// the part where speed matters. See trebuchet.h for how it's meant to be used.
+
+// assert.h used for the assert() function call
+#include <assert.h>
+// limits.h used for upper/lower bounds on types
+#include <limits.h>
+// string.h used for memcmp(), for --where
+#include <string.h>
+
+#include "tables.h"
+#include "trebuchet.h"
+
+/*
+    SIMD stands for "Single Instruction, Multiple Data". Modern CPUs can compare 16 (or more)
+    bytes against a value in a single instruction, instead of looping over them one by one.
+
+    SSE2 is the SIMD instruction set that every 64-bit x86 CPU has. The compiler tells us it's
+    available by defining a macro: GCC and Clang define __SSE2__, MSVC defines _M_X64 (or _M_IX86_FP
+    for 32-bit builds). On other CPUs (like ARM), we fall back to plain loops, which are still correct.
+
+    The functions starting with _mm_ are called "intrinsics". They look like function calls,
+    but the compiler turns each one into a single CPU instruction.
+
+    See: https://en.wikipedia.org/wiki/Single_instruction,_multiple_data
+    See: https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2 1
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef HAVE_SSE2
+/*
+    Count the trailing zero bits of 'mask', i.e. the position of the lowest set bit.
+    'mask' must not be zero.
+
+    There's no portable way to do this before C23's <stdbit.h>, so we use each compiler's built-in.
+    Each one becomes a single instruction (BSF or TZCNT on x86).
+*/
+static inline unsigned trailing_zeros(unsigned mask)
+{
+    assert(mask != 0);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(mask);
+#endif
+}
+#endif
+
+void scan_init(scan_state_t *state)
+{
+    state->digitsSeen = SeenZero;
+    state->calibration[0] = 0;
+    state->calibration[1] = 0;
+    state->sum = 0;
+    state->overflowValue = 0;
+    state->codePoint = 0;
+    state->pending = 0;
+    state->lower = 0x80;
+    state->upper = 0xBF;
+    state->strict = false;
+    state->maxLineLength = DEFAULT_MAX_LINE_LENGTH;
+    state->offset = 0;
+    state->lineStart = 0;
+    state->sequenceStart = 0;
+    state->lines = 0;
+    state->errorOffset = 0;
+    state->words = NULL;
+    state->wordState = 0;
+    state->wordOffset = 0;
+    state->firstStart = 0;
+    state->lastStart = 0;
+    state->groups = NULL;
+    state->outliers = NULL;
+    state->compiler = NULL;
+    state->where = NULL;
+    state->lineMatched = false;
+}
+
+const char *status_message(status_t status)
+{
+    switch (status)
+    {
+    case StatusOk:
+        return "no error";
+    case StatusOverflow:
+        return "integer overflow";
+    case StatusInvalidUtf8:
+        return "invalid UTF-8";
+    case StatusInvalidUtf16:
+        return "unpaired UTF-16 surrogate";
+    case StatusTruncated:
+        return "input ends in the middle of a character";
+    case StatusNul:
+        return "NUL byte";
+    case StatusControl:
+        return "control character";
+    case StatusLineTooLong:
+        return "line too long";
+    case StatusUnsupported:
+        return "unsupported encoding, only UTF-8 and UTF-16LE can be read";
+    case StatusNoMemory:
+        return "out of memory";
+    case StatusGroupEncoding:
+        return "tags can only be read from UTF-8 input";
+    case StatusDamaged:
+        return "damaged compiled input";
+    case StatusWhereEncoding:
+        return "lines can only be matched in UTF-8 input";
+    case StatusCompiled:
+        return "compiled input, which can't be read a block at a time (--threads, --tee, --deadline...) or with --batch or --fan-in";
+    }
+    return "unknown error";
+}
+
+encoding_t detect_encoding(const unsigned char *data, size_t length, size_t *bomLength)
+{
+    if (length >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF)
+    {
+        *bomLength = 3;
+        return EncodingUtf8;
+    }
+    if (length >= 2 && data[0] == 0xFF && data[1] == 0xFE)
+    {
+        *bomLength = 2;
+        return EncodingUtf16le;
+    }
+    if (length >= 2 && data[0] == 0xFE && data[1] == 0xFF)
+    {
+        *bomLength = 2;
+        return EncodingUtf16be;
+    }
+    *bomLength = 0; // No BOM: assume UTF-8.
+    return EncodingUtf8;
+}
+
+// Record where a strict-mode problem is, and hand back its status.
+static inline status_t fail(scan_state_t *state, status_t status, unsigned long long offset)
+{
+    state->errorOffset = offset;
+    return status;
+}
+
+/*
+    Is 'c' a control character that strict mode rejects?
+
+    Control characters are the "invisible" codes like BEL (7) or ESC (27), plus DEL (127) and,
+    beyond ASCII, U+0080 to U+009F. Tab, newline and carriage return are allowed, since ordinary
+    text files are full of them.
+
+    See: https://en.wikipedia.org/wiki/C0_and_C1_control_codes
+*/
+static inline bool is_control(unsigned c)
+{
+    return (c < 0x20 && c != '\t' && c != '\n' && c != '\r') || (c >= 0x7F && c <= 0x9F);
+}
+
+// Strict mode: is the byte at 'position' past the end of the longest line we accept?
+static inline bool line_too_long(const scan_state_t *state, unsigned long long position)
+{
+    return position - state->lineStart >= state->maxLineLength;
+}
+
+/*
+    Record a digit (0-9) for the current line.
+
+    'static inline' asks the compiler to paste this function's body wherever it's called,
+    so there's no cost for splitting the logic into a separate function.
+
+    See: https://en.cppreference.com/w/c/language/inline
+*/
+static inline void see_digit(scan_state_t *state, unsigned digit)
+{
+    assert(digit <= 9);
+    if (state->digitsSeen == SeenZero) // If we haven't seen anything, this is the first digit this line.
+    {
+        state->digitsSeen = SeenOne;
+        state->calibration[0] = (unsigned char)digit;
+    }
+    // If we've seen one digit, this is the second digit.
+    // If we've seen two digits, this is currently the rightmost digit.
+    else
+    {
+        state->digitsSeen = SeenTwo;
+        state->calibration[1] = (unsigned char)digit;
+    }
+}
+
+// Words mode: record a digit (or spelled-out digit) that starts at 'start'. See 'words' in trebuchet.h.
+static inline void see_match(scan_state_t *state, unsigned digit, unsigned long long start)
+{
+    assert(digit <= 9);
+    if (state->digitsSeen == SeenZero) // The first match this line is both the first and the last digit, so far.
+    {
+        state->digitsSeen = SeenOne;
+        state->calibration[0] = state->calibration[1] = (unsigned char)digit;
+        state->firstStart = state->lastStart = start;
+        return;
+    }
+    state->digitsSeen = SeenTwo;
+    if (start <= state->firstStart)
+    {
+        state->calibration[0] = (unsigned char)digit;
+        state->firstStart = start;
+    }
+    if (start >= state->lastStart)
+    {
+        state->calibration[1] = (unsigned char)digit;
+        state->lastStart = start;
+    }
+}
+
+/*
+    Words mode: feed one byte to the automaton, and record any words that end on it.
+
+    This is one table lookup, however many words the vocabulary has.
+*/
+static inline void see_word_byte(scan_state_t *state, unsigned byte)
+{
+    const words_t *words = state->words;
+    unsigned next = words->next[state->wordState * words->classes + words->classOf[byte]];
+    unsigned long long end = ++state->wordOffset; // One past this byte.
+    state->wordState = next;
+
+    unsigned shortest = words->shortest[next], longest = words->longest[next];
+    if (shortest == 0) // No word ends here (the usual case).
+        return;
+    see_match(state, longest & 0xF, end - (longest >> 4));
+    if (shortest != longest)
+        see_match(state, shortest & 0xF, end - (shortest >> 4));
+}
+
+// Record a digit from the slow path, where words mode might be on.
+static inline void see_number(scan_state_t *state, unsigned digit)
+{
+    if (state->words != NULL)
+        see_match(state, digit, state->wordOffset - 1); // The digit's last byte was just fed to the automaton.
+    else
+        see_digit(state, digit);
+}
+
+// We're at the end of a line, so sum the values up. The line ends just before 'position'.
+static inline status_t end_line(scan_state_t *state, unsigned long long position)
+{
+    assert(state->sum >= 0);
+
+    if (state->strict && position - state->lineStart > state->maxLineLength)
+        return fail(state, StatusLineTooLong, state->lineStart + state->maxLineLength);
+    if (state->digitsSeen == SeenOne) // If we've seen only one digit, then the left and right digits are the same.
+    {
+        state->calibration[1] = state->calibration[0];
+        state->digitsSeen = SeenTwo; // We've now "seen" two digits, which is checked in the next if-statement.
+    }
+    int value = -1; // No digits, so far.
+    bool counted = state->where == NULL || state->lineMatched; // With 'where', only the lines it matched count.
+    if (state->digitsSeen == SeenTwo && counted) // If we've seen two digits, then convert to an integer and sum.
+    {
+        value = state->calibration[0] * 10 + state->calibration[1];
+        // Figure out if adding sum+value would overflow the maximum value of an integer.
+        if (state->compiler == NULL && value > INT_MAX - state->sum)
+        {
+            state->overflowValue = value;
+            return StatusOverflow;
+        }
+        if (state->compiler == NULL) // Compiling keeps each line's value instead, so there's no sum to overflow.
+            state->sum += value;
+    }
+    if (state->outliers != NULL && counted) // The line is at hand right now, and never again, so this is where to look at it.
+        outliers_add(state->outliers, state->lineStart, position - state->lineStart, value);
+    if (state->compiler != NULL && !compiler_add(state->compiler, position - state->lineStart, value))
+        return StatusNoMemory;
+    state->digitsSeen = SeenZero; // Reset number of digits seen.
+    state->lineMatched = false;
+    state->lines++;
+    return StatusOk;
+}
+
+/*
+    Handle a single character at 'position', which is 'width' bytes long (1 for UTF-8, 2 for UTF-16).
+
+    Only digits and newlines matter here. Anything else is ignored.
+*/
+static inline status_t see_char(scan_state_t *state, unsigned c, unsigned long long position, unsigned width)
+{
+    status_t status;
+
+    if (c == '\n')
+    {
+        if ((status = end_line(state, position)) == StatusOk)
+            state->lineStart = position + width; // The next line starts after the newline.
+        return status;
+    }
+    if (c - '0' <= 9) // Unsigned math: anything below '0' wraps around to a huge number.
+        see_digit(state, c - '0');
+    return StatusOk;
+}
+
+// Like see_char(), but for any ASCII character, in words mode or not.
+static inline status_t see_ascii(scan_state_t *state, unsigned c, unsigned long long position, unsigned width)
+{
+    if (state->words == NULL)
+        return see_char(state, c, position, width);
+    see_word_byte(state, c);
+    if (c - '0' <= 9)
+    {
+        see_number(state, c - '0');
+        return StatusOk;
+    }
+    return see_char(state, c, position, width); // A newline, or nothing interesting.
+}
+
+/*
+    The first code point ("zero") of every run of Unicode decimal digits, from Unicode 15.0.
+
+    Unicode always assigns decimal digits in complete runs of ten, from zero to nine, so
+    the value of a digit is just its distance from the zero of its run.
+
+    The list is sorted, which lets unicode_digit() use a binary search: each step throws
+    away half of the remaining entries, so 68 entries take at most 7 steps.
+
+    It can be regenerated with Python:
+        [hex(c) for c in range(0x110000) if unicodedata.category(chr(c)) == 'Nd' and unicodedata.decimal(chr(c)) == 0]
+
+    See: https://www.unicode.org/Public/15.0.0/ucd/extracted/DerivedNumericType.txt
+    See: https://en.wikipedia.org/wiki/Binary_search_algorithm
+*/
+static const unsigned DigitZeros[] = {
+    0x0030, 0x0660, 0x06F0, 0x07C0, 0x0966, 0x09E6, 0x0A66, 0x0AE6,
+    0x0B66, 0x0BE6, 0x0C66, 0x0CE6, 0x0D66, 0x0DE6, 0x0E50, 0x0ED0,
+    0x0F20, 0x1040, 0x1090, 0x17E0, 0x1810, 0x1946, 0x19D0, 0x1A80,
+    0x1A90, 0x1B50, 0x1BB0, 0x1C40, 0x1C50, 0xA620, 0xA8D0, 0xA900,
+    0xA9D0, 0xA9F0, 0xAA50, 0xABF0, 0xFF10, 0x104A0, 0x10D30, 0x11066,
+    0x110F0, 0x11136, 0x111D0, 0x112F0, 0x11450, 0x114D0, 0x11650, 0x116C0,
+    0x11730, 0x118E0, 0x11950, 0x11C50, 0x11D50, 0x11DA0, 0x11F50, 0x16A60,
+    0x16AC0, 0x16B50, 0x1D7CE, 0x1D7D8, 0x1D7E2, 0x1D7EC, 0x1D7F6, 0x1E140,
+    0x1E2F0, 0x1E4F0, 0x1E950, 0x1FBF0,
+};
+
+int unicode_digit(unsigned codePoint)
+{
+    // Find the last zero that is <= codePoint.
+    size_t low = 0, high = sizeof DigitZeros / sizeof DigitZeros[0];
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (DigitZeros[middle] <= codePoint)
+            low = middle;
+        else
+            high = middle;
+    }
+    unsigned value = codePoint - DigitZeros[low]; // Wraps to a huge number if codePoint < '0'.
+    return value <= 9 ? (int)value : -1;
+}
+
+/*
+    Handle the byte at 'position', which might be part of a multi-byte character.
+
+    UTF-8 stores a character in 1 to 4 bytes. The first ("lead") byte says how many bytes follow,
+    and each following ("continuation") byte carries 6 more bits of the character's number:
+
+        0xxxxxxx                              1 byte,  ASCII
+        110xxxxx 10xxxxxx                     2 bytes
+        1110xxxx 10xxxxxx 10xxxxxx            3 bytes
+        11110xxx 10xxxxxx 10xxxxxx 10xxxxxx   4 bytes
+
+    We collect the bits in 'state', so a character split across two scan_utf8() calls still works.
+    Normally, broken sequences (a missing or unexpected continuation byte) are quietly skipped.
+
+    In strict mode they're errors. So are the sneakier problems: "overlong" encodings that use more
+    bytes than needed (C0 80 for NUL), the surrogates D800-DFFF (which belong to UTF-16), and anything
+    above U+10FFFF. All of those are ruled out by the lead byte itself, or by narrowing the range of
+    the first continuation byte, using the table from the Unicode standard:
+
+        Lead byte   First continuation
+        E0          A0..BF
+        ED          80..9F
+        F0          90..BF
+        F4          80..8F
+        others      80..BF
+
+    Rather than a chain of if-statements, each byte is looked up in ByteClass[] and Utf8Lead[],
+    which gen_tables.c generates while building.
+
+    See: https://en.wikipedia.org/wiki/UTF-8#Encoding
+    See: https://www.unicode.org/versions/Unicode15.0.0/ch03.pdf (Table 3-7, "Well-Formed UTF-8 Byte Sequences")
+*/
+static inline status_t see_byte_utf8(scan_state_t *state, unsigned byte, unsigned long long position)
+{
+    int digit;
+    unsigned class = ByteClass[byte];
+
+    if (state->strict && byte != '\n' && line_too_long(state, position))
+        return fail(state, StatusLineTooLong, state->lineStart + state->maxLineLength);
+    if (byte >= 0x80 && state->words != NULL) // Words can contain non-ASCII letters, like "fünf". (ASCII is fed in see_ascii().)
+        see_word_byte(state, byte);
+
+    if (byte < 0x80) // ASCII. This also abandons any unfinished sequence.
+    {
+        if (state->pending != 0 && state->strict)
+            return fail(state, StatusInvalidUtf8, state->sequenceStart);
+        state->pending = 0;
+        if (state->strict && (class & BYTE_CONTROL))
+            return fail(state, byte == 0 ? StatusNul : StatusControl, position);
+        return see_ascii(state, byte, position, 1);
+    }
+    if (class & BYTE_CONTINUATION)
+    {
+        if (state->pending == 0) // Nothing to continue, so skip it.
+            return state->strict ? fail(state, StatusInvalidUtf8, position) : StatusOk;
+        if (state->strict && (byte < state->lower || byte > state->upper))
+            return fail(state, StatusInvalidUtf8, state->sequenceStart);
+        state->lower = 0x80; // Only the first continuation byte has a narrower range.
+        state->upper = 0xBF;
+        state->codePoint = state->codePoint << 6 | (byte & 0x3F);
+        if (--state->pending != 0)
+            return StatusOk;
+        if (state->strict && is_control(state->codePoint))
+            return fail(state, StatusControl, state->sequenceStart);
+        if ((digit = unicode_digit(state->codePoint)) >= 0)
+            see_number(state, (unsigned)digit);
+        return StatusOk;
+    }
+
+    // Lead byte (or a byte that can't start anything). The table says how to decode the rest.
+    if (state->pending != 0 && state->strict) // The previous character wasn't finished.
+        return fail(state, StatusInvalidUtf8, state->sequenceStart);
+    if (state->strict && (class & BYTE_INVALID))
+        return fail(state, StatusInvalidUtf8, position);
+    const utf8_lead_t *lead = &Utf8Lead[byte];
+    state->sequenceStart = position;
+    state->codePoint = byte & lead->mask;
+    state->pending = lead->pending; // 0 for bytes that are never valid, which are then skipped.
+    state->lower = lead->lower;
+    state->upper = lead->upper;
+    return StatusOk;
+}
+
+/*
+    Handle the UTF-16 code unit at 'position'.
+
+    Characters above U+FFFF don't fit in 16 bits, so UTF-16 splits them into two "surrogate" units:
+    a high surrogate (D800-DBFF) followed by a low surrogate (DC00-DFFF), each carrying 10 bits.
+    A surrogate without its partner is skipped, or an error in strict mode.
+
+    See: https://en.wikipedia.org/wiki/UTF-16#Code_points_from_U+010000_to_U+10FFFF
+*/
+static inline status_t see_unit_utf16(scan_state_t *state, unsigned unit, unsigned long long position)
+{
+    int digit;
+
+    if (state->strict && unit != '\n' && line_too_long(state, position))
+        return fail(state, StatusLineTooLong, state->lineStart + state->maxLineLength);
+
+    if (unit >= 0xDC00 && unit <= 0xDFFF) // Low surrogate: only meaningful right after a high one.
+    {
+        if (state->pending == 0)
+            return state->strict ? fail(state, StatusInvalidUtf16, position) : StatusOk;
+        unit = 0x10000 + (state->codePoint << 10 | (unit - 0xDC00));
+    }
+    else if (state->pending != 0 && state->strict) // The high surrogate before this one is missing its partner.
+        return fail(state, StatusInvalidUtf16, state->sequenceStart);
+    if (unit >= 0xD800 && unit <= 0xDBFF) // High surrogate: remember it and wait for the low one.
+    {
+        state->codePoint = unit - 0xD800;
+        state->pending = 1;
+        state->sequenceStart = position;
+        return StatusOk;
+    }
+    state->pending = 0;
+    if (state->strict && (unit == 0 || is_control(unit)))
+        return fail(state, unit == 0 ? StatusNul : StatusControl, position);
+    if (unit < 0x80)
+        return see_ascii(state, unit, position, 2);
+    if (state->words != NULL) // The vocabulary is in UTF-8, so convert the character to UTF-8 bytes for the automaton.
+    {
+        if (unit < 0x800)
+            see_word_byte(state, 0xC0 | unit >> 6);
+        else
+        {
+            if (unit < 0x10000)
+                see_word_byte(state, 0xE0 | unit >> 12);
+            else
+            {
+                see_word_byte(state, 0xF0 | unit >> 18);
+                see_word_byte(state, 0x80 | (unit >> 12 & 0x3F));
+            }
+            see_word_byte(state, 0x80 | (unit >> 6 & 0x3F));
+        }
+        see_word_byte(state, 0x80 | (unit & 0x3F));
+    }
+    if ((digit = unicode_digit(unit)) >= 0)
+        see_number(state, (unsigned)digit);
+    return StatusOk;
+}
+
+// 'where' matched at 'position': the line counts, if it's a match we're looking for.
+static inline void see_where(scan_state_t *state, unsigned long long position)
+{
+    if (!state->where->prefix || position == state->lineStart)
+        state->lineMatched = true;
+}
+
+// Whether 'where' matches at data[i], with all of it before 'length'.
+static inline bool where_at(const where_t *where, const unsigned char *data, size_t length, size_t i)
+{
+    return where->length <= length - i && data[i] == where->text[0] && memcmp(data + i, where->text, where->length) == 0;
+}
+
+#ifdef HAVE_SSE2
+/*
+    Find everywhere in data[i] to data[i + 15] that 'where' matches, as a mask like the one in scan_utf8(). A
+    bit for each match, rather than a branch, keeps the loops that visit them from guessing wrong at each one.
+
+    A match has to start with the text's first byte, and have its last byte where the text's last byte goes.
+    Two comparisons check that for 16 places at once: one of the block against the first byte, and one of the
+    block 'length - 1' bytes further on against the last. Where both agree, memcmp() checks the rest. Most
+    blocks have no place where both agree, and cost just the two comparisons. With 'prefix', the only places
+    that matter are where lines start: just after a newline ('newlines' has a bit for each one in the block).
+
+    See: http://0x80.pl/articles/simd-strfind.html ("generic SIMD")
+*/
+static inline unsigned where_matches(const where_t *where, const unsigned char *data, size_t length, size_t i,
+                                     unsigned newlines)
+{
+    size_t last = where->length - 1;
+    unsigned candidates = 0;
+    if (length - i < 16 + last) // The second block would run past the end: check each place instead.
+    {
+        for (size_t j = i; j < i + 16; j++)
+            candidates |= (unsigned)where_at(where, data, length, j) << (j - i);
+    }
+    else
+    {
+        __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i)), _mm_set1_epi8((char)where->text[0]));
+        __m128i final = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + i + last)), _mm_set1_epi8((char)where->text[last]));
+        candidates = (unsigned)_mm_movemask_epi8(_mm_and_si128(first, final));
+    }
+    if (where->prefix) // Data always starts at the start of a line (see 'where' in trebuchet.h).
+        candidates &= newlines << 1 | (i == 0 || data[i - 1] == '\n');
+    if (where->length <= 2) // The first and last bytes are all of it.
+        return candidates;
+    unsigned matches = candidates;
+    while (candidates != 0)
+    {
+        unsigned bit = trailing_zeros(candidates);
+        if (memcmp(data + i + bit, where->text, where->length) != 0)
+            matches &= ~(1u << bit);
+        candidates &= candidates - 1;
+    }
+    return matches;
+}
+#endif
+
+status_t scan_utf8(scan_state_t *state, const unsigned char *data, size_t length)
+{
+    status_t status;
+    const unsigned long long base = state->offset; // Offset of data[0] in the whole input.
+    size_t i = 0;
+
+#ifdef HAVE_SSE2
+    /*
+        Most bytes of the input are letters, which we don't care about.
+
+        Instead of looking at each byte, we load 16 at a time and build a "mask": a 16-bit number
+        where bit N is set if byte N is a digit or a newline. If the mask is zero, we skip all 16
+        bytes at once. Otherwise, we visit just the set bits.
+
+        That only works for ASCII. Every byte of a multi-byte UTF-8 character has its top bit set,
+        and _mm_movemask_epi8 collects exactly those top bits. So one instruction tells us whether
+        the block is pure ASCII. If it isn't (or a character from the last block isn't finished yet),
+        we walk the block one byte at a time with see_byte_utf8() instead.
+
+        Strict mode adds its checks to the same pass, rather than reading the input twice.
+        Pure ASCII is always valid UTF-8, so all that's left is to look for control characters,
+        which costs three more comparisons per block. Any block with a problem goes to the slow
+        path, which finds the exact byte. Line lengths are checked at each newline, and once at
+        the end of each block.
+
+        So does --where: the places where its text starts go in the same mask, so they're visited
+        in order with the digits and newlines, and each one marks its line as matched.
+    */
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    for (; i + 16 <= length && state->words == NULL; i += 16) // Words mode needs every byte, so it skips this loop.
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i isNewline = _mm_cmpeq_epi8(block, newline);
+        unsigned special = (unsigned)_mm_movemask_epi8(block); // Top bits: the non-ASCII bytes.
+        if (state->strict)
+        {
+            // Bytes below ' ' (except tab, newline, carriage return), and DEL. The comparison is signed,
+            // so non-ASCII bytes count as "below ' '" too, but those already send us down the slow path.
+            __m128i allowed = _mm_or_si128(isNewline, _mm_or_si128(_mm_cmpeq_epi8(block, tab), _mm_cmpeq_epi8(block, carriageReturn)));
+            __m128i isControl = _mm_or_si128(_mm_andnot_si128(allowed, _mm_cmplt_epi8(block, space)), _mm_cmpeq_epi8(block, del));
+            special |= (unsigned)_mm_movemask_epi8(isControl);
+        }
+        unsigned matches = 0;
+        if (state->where != NULL)
+            matches = where_matches(state->where, data, length, i, (unsigned)_mm_movemask_epi8(isNewline));
+        if (special != 0 || state->pending != 0) // Not plain ASCII text: take the slow path.
+        {
+            for (size_t j = i; j < i + 16; j++)
+            {
+                state->lineMatched |= matches >> (j - i) & 1;
+                if ((status = see_byte_utf8(state, data[j], base + j)) != StatusOk)
+                    return status;
+            }
+            continue;
+        }
+        // Digits are the bytes where (byte - '0') is between 0 and 9. _mm_subs_epu8 "saturates" at 0,
+        // so (byte - '0') - 9 is 0 exactly when the byte is a digit.
+        __m128i offset = _mm_sub_epi8(block, zero);
+        __m128i isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(offset, nine), _mm_setzero_si128());
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(isDigit, isNewline)) | matches;
+        while (mask != 0)
+        {
+            unsigned bit = trailing_zeros(mask);
+            size_t j = i + bit;
+            state->lineMatched |= matches >> bit & 1; // It can be a digit too, so carry on to see_char() either way.
+            if ((status = see_char(state, data[j], base + j, 1)) != StatusOk)
+                return status;
+            mask &= mask - 1; // Clear the lowest set bit.
+        }
+        if (state->strict && base + i + 16 - state->lineStart > state->maxLineLength) // The line so far is too long.
+            return fail(state, StatusLineTooLong, state->lineStart + state->maxLineLength);
+    }
+#endif
+
+    for (; i < length; i++) // Whatever is left over (or everything, without SSE2).
+    {
+        if (state->where != NULL && where_at(state->where, data, length, i))
+            see_where(state, base + i);
+        if ((status = see_byte_utf8(state, data[i], base + i)) != StatusOk)
+            return status;
+    }
+    state->offset = base + length;
+    return StatusOk;
+}
+
+status_t scan_utf16le(scan_state_t *state, const unsigned char *data, size_t length)
+{
+    status_t status;
+    const unsigned long long base = state->offset;
+    size_t i = 0;
+
+    if (state->where != NULL) // The text to match is UTF-8.
+        return StatusWhereEncoding;
+    if (length % 2 != 0) // UTF-16 "code units" are two bytes each, so a stray odd byte can't be a character.
+    {
+        if (state->strict)
+            return fail(state, StatusTruncated, base + length - 1);
+        length--;
+    }
+
+#ifdef HAVE_SSE2
+    /*
+        The same idea as scan_utf8(), but each vector holds 8 code units of 16 bits.
+
+        Digits and newlines in UTF-16 are the same numbers as in ASCII, just stored in two bytes.
+        Comparing whole 16-bit units means a character like U+0A31 (low byte 0x31, which is '1')
+        is never confused for a digit.
+
+        A unit is ASCII when it's at most 0x7F. Subtracting 0x7F with saturation leaves 0 for
+        exactly those units, so a block is pure ASCII when every unit compares equal to zero.
+    */
+    const __m128i zero = _mm_set1_epi16('0');
+    const __m128i nine = _mm_set1_epi16(9);
+    const __m128i newline = _mm_set1_epi16('\n');
+    const __m128i asciiMax = _mm_set1_epi16(0x7F);
+    const __m128i space = _mm_set1_epi16(' ');
+    const __m128i del = _mm_set1_epi16(0x7F);
+    const __m128i tab = _mm_set1_epi16('\t');
+    const __m128i carriageReturn = _mm_set1_epi16('\r');
+    for (; i + 16 <= length && state->words == NULL; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i isNewline = _mm_cmpeq_epi16(block, newline);
+        __m128i isAscii = _mm_cmpeq_epi16(_mm_subs_epu16(block, asciiMax), _mm_setzero_si128());
+        unsigned special = (unsigned)_mm_movemask_epi8(isAscii) ^ 0xFFFFu; // Bits for the non-ASCII units.
+        if (state->strict)
+        {
+            __m128i allowed = _mm_or_si128(isNewline, _mm_or_si128(_mm_cmpeq_epi16(block, tab), _mm_cmpeq_epi16(block, carriageReturn)));
+            __m128i isControl = _mm_or_si128(_mm_andnot_si128(allowed, _mm_cmplt_epi16(block, space)), _mm_cmpeq_epi16(block, del));
+            special |= (unsigned)_mm_movemask_epi8(isControl);
+        }
+        if (special != 0 || state->pending != 0) // Not plain ASCII text: take the slow path.
+        {
+            for (size_t j = i; j < i + 16; j += 2)
+                if ((status = see_unit_utf16(state, data[j] | (unsigned)data[j + 1] << 8, base + j)) != StatusOk)
+                    return status;
+            continue;
+        }
+        __m128i offset = _mm_sub_epi16(block, zero);
+        __m128i isDigit = _mm_cmpeq_epi16(_mm_subs_epu16(offset, nine), _mm_setzero_si128());
+        // movemask gives one bit per byte, so each code unit sets two bits. Keep just the lower one.
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(isDigit, isNewline)) & 0x5555u;
+        while (mask != 0)
+        {
+            size_t j = i + trailing_zeros(mask);
+            if ((status = see_char(state, data[j], base + j, 2)) != StatusOk)
+                return status;
+            mask &= mask - 1;
+        }
+        if (state->strict && base + i + 16 - state->lineStart > state->maxLineLength) // The line so far is too long.
+            return fail(state, StatusLineTooLong, state->lineStart + state->maxLineLength);
+    }
+#endif
+
+    for (; i < length; i += 2)
+    {
+        unsigned unit = data[i] | (unsigned)data[i + 1] << 8; // Little-endian: the low byte comes first.
+        if ((status = see_unit_utf16(state, unit, base + i)) != StatusOk)
+            return status;
+    }
+    state->offset = base + length;
+    return StatusOk;
+}
+
+status_t scan_finish(scan_state_t *state)
+{
+    if (state->pending != 0 && state->strict)
+        return fail(state, StatusTruncated, state->sequenceStart);
+    if (state->offset == state->lineStart) // The input ended with a newline (or is empty), so there's no last line.
+        return StatusOk;
+    return end_line(state, state->offset); // The file ends like a line does.
+}
+
+status_t scan_input(scan_state_t *state, const unsigned char *data, size_t length)
+{
+    size_t bomLength;
+    status_t status;
+
+    encoding_t encoding = detect_encoding(data, length, &bomLength);
+    state->offset = bomLength; // So that error offsets count the BOM, and match what a hex editor shows.
+    state->lineStart = bomLength;
+    switch (encoding)
+    {
+    case EncodingUtf8:
+        if (state->groups != NULL)
+            status = scan_groups(state, data + bomLength, length - bomLength);
+        else
+            status = scan_utf8(state, data + bomLength, length - bomLength);
+        break;
+    case EncodingUtf16le:
+        if (state->groups != NULL) // Tags are split off as bytes, which only works for UTF-8.
+            return StatusGroupEncoding;
+        status = scan_utf16le(state, data + bomLength, length - bomLength);
+        break;
+    default: // Anything we detect but can't scan, like UTF-16BE.
+        return StatusUnsupported;
+    }
+    if (status != StatusOk)
+        return status;
+    return scan_finish(state); // The last line might not end in a newline.
+}
+
+// Scan a whole input with 'words' (or NULL), for trebuchet_part1() and trebuchet_part2().
+static const char *solve(const unsigned char *data, size_t length, const words_t *words, long long *answer)
+{
+    scan_state_t state;
+    scan_init(&state);
+    state.words = words;
+    status_t status = scan_input(&state, data, length);
+    if (status != StatusOk)
+        return status_message(status);
+    *answer = state.sum;
+    return NULL;
+}
+
+const char *trebuchet_part1(const unsigned char *data, size_t length, long long *answer)
+{
+    return solve(data, length, NULL, answer);
+}
+
+const char *trebuchet_part2(const unsigned char *data, size_t length, long long *answer)
+{
+    return solve(data, length, &EnglishWords, answer);
+}
@@ -0,0 +1,313 @@
+// This file declares the "core" of the Day 1 solution: the code that turns input bytes into a sum.
+//
+// main.c handles everything about being a program (arguments, files, printing).
+// trebuchet.c handles everything about scanning the text.
+//
+// Splitting the two apart means the scanner can be called from other places later on,
+// like a test program, without dragging the command-line handling along with it.
+
+/*
+    An "include guard" stops this header from being pasted into the same source file twice.
+    If it were, the compiler would complain that every type is declared twice.
+
+    See: https://en.wikipedia.org/wiki/Include_guard
+*/
+#ifndef TREBUCHET_H
+#define TREBUCHET_H
+
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+// stdio.h used for FILE, in compile_input()
+#include <stdio.h>
+
+// words.h declares the automaton for spelled-out digits
+// group.h declares the per-tag sums that scan_groups() fills in
+// outlier.h declares the lines that stand out, which the scanner can collect as it goes
+// compiled.h declares compiled inputs, which compile_input() writes and scan_compiled() reads
+// cache.h declares the chunk cache, which scan_cached() reads and fills in
+// aoc_runtime.h declares aoc_span_t, used by scan_batch(), and aoc_pipeline_t, used by scan_pipeline()
+#include "aoc_runtime.h"
+#include "cache.h"
+#include "compiled.h"
+#include "group.h"
+#include "outlier.h"
+#include "words.h"
+
+/*
+    Seen describes how many numbers we've seen this line,
+    ranging from 0 until 2.
+
+    Enums are, by default, an integer which starts at 0 and goes up by 1 each time.
+    So we can treat this like an integer.
+
+    Enumerations in C are data types that let us assign human-readable names
+    to special constant values.
+
+    The 'typedef' says that 'seen_t' is a type alias for 'enum SEEN'.
+    Without the typedef, we'd have to use 'enum SEEN x = SeenZero;' to
+    declare and initialize an 'enum SEEN' type. Because of the typedef, we
+    can write 'seen_t x = SeenZero;'.
+
+    See: https://en.cppreference.com/w/cpp/language/enum
+    See: https://en.cppreference.com/w/c/language/typedef
+
+
+    Wikipedia or Geeks for Geeks are other online resources.
+*/
+typedef enum SEEN
+{
+    SeenZero,
+    SeenOne,
+    SeenTwo
+} seen_t;
+
+/*
+    The text encodings we know how to scan.
+
+    A file tells us its encoding with a "Byte Order Mark" (BOM), a few special bytes at the very start.
+    No BOM means we assume UTF-8, which is a superset of ASCII.
+
+    See: https://en.wikipedia.org/wiki/Byte_order_mark
+*/
+typedef enum ENCODING
+{
+    EncodingUtf8,    // UTF-8 (or plain ASCII), with or without the EF BB BF mark.
+    EncodingUtf16le, // UTF-16, little-endian, marked with FF FE. Common on Windows.
+    EncodingUtf16be  // UTF-16, big-endian, marked with FE FF. Detected, but not scanned.
+} encoding_t;
+
+/*
+    The result of scanning some bytes.
+
+    The scanner never prints or exits by itself. It hands back a status and
+    lets the caller (main.c) decide what to tell the user.
+*/
+typedef enum STATUS
+{
+    StatusOk,           // Everything went fine.
+    StatusOverflow,     // The sum no longer fits in an 'int'.
+    StatusInvalidUtf8,  // Strict mode: bytes that aren't valid UTF-8.
+    StatusInvalidUtf16, // Strict mode: a surrogate without its partner.
+    StatusTruncated,    // Strict mode: the input ends in the middle of a character.
+    StatusNul,          // Strict mode: a NUL byte (character 0).
+    StatusControl,      // Strict mode: a control character other than tab, newline or carriage return.
+    StatusLineTooLong,  // Strict mode: a line longer than 'maxLineLength' bytes.
+    StatusUnsupported,  // An encoding we can detect, but not scan (UTF-16BE).
+    StatusNoMemory,      // No memory for another group (see 'groups' in scan_state_t), or for compile_input().
+    StatusGroupEncoding, // Groups: tags are only split off UTF-8 input.
+    StatusDamaged,       // A compiled input whose line lengths run out early.
+    StatusWhereEncoding, // 'where': lines are only matched in UTF-8 input.
+    StatusCompiled       // A compiled input, given to something that only reads text (a pipeline, or scan_batch()).
+} status_t;
+
+/*
+    Which lines count towards the sum, for --where: the lines that contain 'text' somewhere, or with 'prefix',
+    the lines that start with it. The text is compared byte by byte, so it's UTF-8, like the input must be.
+    It can't contain a newline, and it can't be empty.
+*/
+typedef struct WHERE
+{
+    const unsigned char *text;
+    size_t length;
+    bool prefix;
+} where_t;
+
+/*
+    Everything the scanner needs to remember between calls.
+
+    Because this lives in a struct rather than in local variables, you can feed the
+    scanner a file in several pieces and it picks up exactly where it left off.
+*/
+typedef struct SCAN_STATE
+{
+    seen_t digitsSeen;            // Number of digits seen this line.
+    unsigned char calibration[2]; // Leftmost and rightmost digit values (0-9) for this line.
+    int sum;                      // Running sum of the values.
+    int overflowValue;            // The line value that would have overflowed 'sum', for error messages.
+    unsigned codePoint;           // The character being decoded, when it's spread over several bytes or units.
+    unsigned pending;             // How many more bytes (UTF-8) or units (UTF-16) 'codePoint' needs.
+    unsigned char lower, upper;   // The range the next UTF-8 continuation byte must fall in.
+
+    bool strict;          // Reject malformed input instead of skipping over it. Set after scan_init().
+    size_t maxLineLength; // In strict mode, the longest line (in bytes, without the newline) we accept.
+
+    // Byte offsets count from the start of the input, including any BOM.
+    // 'unsigned long long' is at least 64 bits, so offsets don't wrap even for huge files on 32-bit systems.
+    unsigned long long offset;        // Offset of the first byte passed to the next scan_*() call.
+    unsigned long long lineStart;     // Offset of the first byte of the current line.
+    unsigned long long sequenceStart; // Offset of the first byte of the character being decoded.
+    unsigned long long lines;         // Number of lines finished so far.
+    unsigned long long errorOffset;   // When a scan fails in strict mode, the offset of the problem.
+
+    /*
+        Spelled-out digits, like "one". Set 'words' after scan_init() to turn them on.
+
+        Words can overlap ("twone" is both "two" and "one"), and a longer word can finish after a shorter
+        one that starts later, so the order words finish in isn't always the order they start in. We
+        remember where the current first and last digits start, and a new match only replaces them if
+        it starts earlier (or later). When two matches start at the same place, the longer one wins.
+    */
+    const words_t *words;             // The vocabulary, or NULL for digits only.
+    unsigned wordState;               // The automaton's current state.
+    unsigned long long wordOffset;    // How many bytes have been fed to the automaton.
+    unsigned long long firstStart;    // Where the first digit of this line starts, counted like 'wordOffset'.
+    unsigned long long lastStart;     // Where the last digit of this line starts.
+
+    /*
+        Set 'groups' after scan_init() to sum each line into its tag's group, instead of into 'sum'
+        (see group.h). scan_input() then scans with scan_groups(), and 'sum' ends at 0.
+    */
+    groups_t *groups;
+
+    // Set 'outliers' after scan_init() to offer it every line as it ends (see outlier.h).
+    outliers_t *outliers;
+
+    // Set by compile_input() to record every line as it ends. Lines aren't summed then: 'sum' stays as it was.
+    compiler_t *compiler;
+
+    /*
+        Set 'where' after scan_init() to only add up the lines it matches. Other lines are still counted in
+        'lines' (and checked by strict mode), but their values don't go in the sum, or to 'outliers'. The
+        text is looked for in the same pass that finds digits and newlines (see scan_utf8() in trebuchet.c),
+        so the scan_utf8() calls must be given whole lines. Groups can't be used with it.
+    */
+    const where_t *where;
+    bool lineMatched; // Whether 'where' matched the current line.
+} scan_state_t;
+
+// The longest line strict mode accepts, unless the caller picks something else.
+#define DEFAULT_MAX_LINE_LENGTH 4096
+
+// Reset 'state' so that it's ready to scan a new input.
+void scan_init(scan_state_t *state);
+
+// A short description of 'status', for error messages.
+const char *status_message(status_t status);
+
+/*
+    Look at the start of 'data' for a Byte Order Mark.
+
+    Returns the encoding, and stores the number of BOM bytes to skip in 'bomLength'.
+*/
+encoding_t detect_encoding(const unsigned char *data, size_t length, size_t *bomLength);
+
+/*
+    Returns the value (0-9) of a Unicode decimal digit, or -1 if 'codePoint' isn't one.
+
+    These are the characters in the Unicode category "Nd" (Number, decimal digit), which
+    includes '0' to '9', but also digits like Arabic-Indic '٣' (U+0663) and fullwidth '３' (U+FF13).
+
+    See: https://www.unicode.org/reports/tr44/#General_Category_Values
+*/
+int unicode_digit(unsigned codePoint);
+
+// Scan 'length' bytes of UTF-8 text. The BOM must already be skipped.
+status_t scan_utf8(scan_state_t *state, const unsigned char *data, size_t length);
+
+/*
+    Scan 'length' bytes of UTF-16LE text. The BOM must already be skipped.
+
+    A trailing odd byte is ignored, or reported as StatusTruncated in strict mode, so
+    when feeding the input in pieces, split it at even offsets.
+*/
+status_t scan_utf16le(scan_state_t *state, const unsigned char *data, size_t length);
+
+// Finish the last line, which may not end in a newline. Call this once, after all the scan_*() calls.
+status_t scan_finish(scan_state_t *state);
+
+/*
+    Scan 'length' bytes of UTF-8 text, a whole number of lines, into 'state->groups': each line's tag is
+    split off, and the rest of the line is scanned like scan_utf8() would, and added to the tag's group.
+    The last line doesn't need a newline; this finishes it. See group.c.
+*/
+status_t scan_groups(scan_state_t *state, const unsigned char *data, size_t length);
+
+/*
+    Scan a whole input that's already in memory: detect its encoding, skip the BOM,
+    scan it, and finish the last line. This is the usual way to call the scanner.
+
+    Set options like 'strict' or 'words' on 'state' (after scan_init()) before calling this.
+*/
+status_t scan_input(scan_state_t *state, const unsigned char *data, size_t length);
+
+/*
+    Scan a whole text input, like scan_input(), and write it to 'out' as a compiled input (see compiled.h),
+    which scan_compiled() reads back. 'state' works like it does for scan_input(), but 'words', 'groups'
+    and 'outliers' must not be set, and 'sum' isn't added to (an input too big to sum can still be compiled).
+    Check 'out' for write errors afterwards.
+*/
+status_t compile_input(scan_state_t *state, const unsigned char *data, size_t length, FILE *out);
+
+/*
+    Scan a compiled input, as scan_input() would have scanned its text, with the same options. 'words' must
+    be NULL or &EnglishWords, and 'strict' is up to the caller: a compiled input can only say whether its
+    text passed (see 'strict' in compiled_t). Groups can't be found, since the tags aren't kept.
+*/
+status_t scan_compiled(scan_state_t *state, const compiled_t *compiled);
+
+/*
+    Scan a whole input like scan_input(), one chunk at a time (see cache.c), taking each chunk's result from
+    'cache' if it has it, and adding every chunk to it, to save for next time. 'groups', 'outliers' and
+    'compiler' must not be set, and 'words' must be NULL or &EnglishWords. UTF-16 inputs aren't cut into
+    chunks: they're just scanned.
+*/
+status_t scan_cached(scan_state_t *state, const unsigned char *data, size_t length, chunk_cache_t *cache);
+
+// What scan_batch() reports for each document: the parts of scan_state_t that describe the result.
+typedef struct SCAN_RESULT
+{
+    status_t status;
+    int sum;
+    int overflowValue;             // For StatusOverflow, as in scan_state_t.
+    unsigned long long lines;      // For strict mode errors, as in scan_state_t.
+    unsigned long long errorOffset; // For strict mode errors, as in scan_state_t.
+} scan_result_t;
+
+/*
+    Scan 'count' separate documents, and store each one's result in 'results' (which has room for 'count').
+
+    It gives the same results as calling scan_input() on each document, with the options (strict,
+    maxLineLength and words) copied from 'options', or the defaults if 'options' is NULL. But for lots of
+    small documents, it's much faster: it scans 16 documents at once, one in each byte of a SIMD vector.
+    See batch.c. A compiled input (see compiled.h) gets StatusCompiled: it isn't text, and scan_input() would
+    scan it as if it were.
+*/
+void scan_batch(const scan_state_t *options, const aoc_span_t *documents, size_t count, scan_result_t *results);
+
+/*
+    Scan the file at 'path' (or standard input, if it's NULL) on several threads, with 'pipeline'
+    (see aoc_pipeline_t in aoc_runtime.h, and parallel.c).
+
+    'state' works like it does for scan_input(): set its options after scan_init(), and afterwards it
+    holds the sum, or the details of an error, exactly as scan_input() would have left them. The scan's
+    status goes in 'status'. Returns NULL, or a message if the input couldn't be read.
+
+    The pipeline only reads text. A compiled input (see compiled.h) gets StatusCompiled, here and in scan_fan_in().
+*/
+const char *scan_pipeline(scan_state_t *state, aoc_pipeline_t *pipeline, const char *path, status_t *status);
+
+/*
+    Scan the 'count' files at 'paths' at once, with 'pipeline' (see aoc_pipeline_fan_in() in aoc_runtime.h),
+    and store each one's result in 'results' (which has room for 'count'). They're usually FIFOs that other
+    programs write lines into as they go: whichever have lines waiting are read, and their lines are scanned
+    on the same workers, but each file's lines are only ever added to its own result.
+
+    The options (strict, maxLineLength, words and where) are copied from 'options', like scan_batch(), and each
+    file's sum starts from options->sum (0 after scan_init()). Returns NULL, or a message if a file couldn't be
+    read, and then 'pipeline->failed' says which.
+*/
+const char *scan_fan_in(const scan_state_t *options, aoc_pipeline_t *pipeline, const char *const *paths, size_t count,
+                        scan_result_t *results);
+
+/*
+    The two parts of the puzzle, in the shape that the multi-day runner (2023/aoc_run.c) calls every day's
+    solution. Part 1 counts digits only, and part 2 also counts spelled-out English digits, like --spelled.
+
+    Each returns NULL and stores the sum in 'answer', or returns a message from status_message().
+*/
+const char *trebuchet_part1(const unsigned char *data, size_t length, long long *answer);
+const char *trebuchet_part2(const unsigned char *data, size_t length, long long *answer);
+
+#endif // TREBUCHET_H
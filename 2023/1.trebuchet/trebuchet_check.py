@@ -0,0 +1,34 @@
+# Checks the "trebuchet" Python module (see trebuchet_python.c), for the PythonBasic02 test.
+#
+# Execute like so:
+#
+# PYTHONPATH=build/2023/1.trebuchet python3 trebuchet_check.py basic02.txt
+
+import mmap
+import sys
+import threading
+
+import trebuchet
+
+with open(sys.argv[1], "rb") as f:
+    # A memory-mapped file is a buffer too, so the module scans the file's pages without any copy.
+    data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    # Scan on several threads at once. The module releases the GIL, so these really do run in parallel.
+    results = [None] * 4
+    def scan(i):
+        results[i] = trebuchet.sum(memoryview(data), spelled=i % 2 == 1)
+    threads = [threading.Thread(target=scan, args=(i,)) for i in range(len(results))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    try:
+        trebuchet.sum(b"1\xc0\xaf2\n", strict=True)
+        error = "none"
+    except ValueError as e:
+        error = str(e)
+
+print("Sums =", *results)
+print("Error =", error)
@@ -0,0 +1,107 @@
+// This file is a Python "extension module": C code that Python can import, like a .py file.
+//
+// It lets Python programs call the scanner directly, without starting a trebuchet process and
+// piping the input to it. Build it by configuring with -DAOC_BUILD_PYTHON=ON, then:
+//
+// PYTHONPATH=build/2023/1.trebuchet python3 -c "import trebuchet; print(trebuchet.sum(b'1abc2'))"
+
+/*
+    Python.h has to come first, before any standard header, because it sets options that change them.
+    PY_SSIZE_T_CLEAN makes length arguments use Py_ssize_t, which every new extension should do.
+
+    See: https://docs.python.org/3/extending/extending.html#a-simple-example
+*/
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+// limits.h used for INT_MAX, in the overflow message
+#include <limits.h>
+
+#include "tables.h"
+#include "trebuchet.h"
+
+/*
+    trebuchet.sum(data, /, *, spelled=False, strict=False, max_line_length=4096) -> int
+
+    'data' can be anything that supports Python's "buffer protocol": bytes, bytearray, memoryview,
+    mmap.mmap, a numpy array... The buffer protocol hands us a pointer to the object's own memory,
+    so the input is never copied, however big it is.
+
+    See: https://docs.python.org/3/c-api/buffer.html
+*/
+static PyObject *trebuchet_sum(PyObject *module, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"", "spelled", "strict", "max_line_length", NULL};
+    Py_buffer buffer;
+    int spelled = 0, strict = 0;
+    Py_ssize_t maxLineLength = DEFAULT_MAX_LINE_LENGTH;
+    (void)module;
+
+    /*
+        "y*" asks for a buffer that's one contiguous block of bytes (an error otherwise), "$" starts the
+        keyword-only arguments, "p" converts anything to true or false, and "n" is a Py_ssize_t.
+
+        See: https://docs.python.org/3/c-api/arg.html
+    */
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|$ppn:sum", keywords, &buffer, &spelled, &strict, &maxLineLength))
+        return NULL;
+    if (maxLineLength <= 0)
+    {
+        PyBuffer_Release(&buffer);
+        return PyErr_Format(PyExc_ValueError, "max_line_length must be positive");
+    }
+
+    scan_state_t state;
+    scan_init(&state);
+    state.strict = strict;
+    state.maxLineLength = (size_t)maxLineLength;
+    state.words = spelled ? &EnglishWords : NULL;
+
+    /*
+        Release the "Global Interpreter Lock" (GIL) while scanning. Only one thread can run Python code at
+        a time, the one holding the GIL, but the scanner doesn't touch any Python objects. Letting go of it
+        means other Python threads keep running, including ones calling trebuchet.sum() on other inputs,
+        which then scan in parallel on different CPUs.
+
+        The buffer stays valid in the meantime, because we hold it until PyBuffer_Release().
+
+        See: https://docs.python.org/3/c-api/init.html#releasing-the-gil-from-extension-code
+    */
+    status_t status;
+    Py_BEGIN_ALLOW_THREADS
+    status = scan_input(&state, buffer.buf, (size_t)buffer.len);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&buffer);
+
+    // Errors become Python exceptions, with the same messages as the trebuchet program prints.
+    if (status == StatusOverflow)
+        return PyErr_Format(PyExc_OverflowError, "integer overflow: %d + %d > %d", state.sum, state.overflowValue, INT_MAX);
+    if (status == StatusUnsupported)
+        return PyErr_Format(PyExc_ValueError, "%s", status_message(status));
+    if (status != StatusOk)
+        return PyErr_Format(PyExc_ValueError, "%s at line %llu, byte offset %llu", status_message(status), state.lines + 1,
+                            state.errorOffset);
+    return PyLong_FromLong(state.sum);
+}
+
+// The functions in the module. A table ending with an empty entry, like main()'s argv ends with NULL.
+static PyMethodDef TrebuchetMethods[] = {
+    {"sum", (PyCFunction)(void (*)(void))trebuchet_sum, METH_VARARGS | METH_KEYWORDS,
+     "sum(data, /, *, spelled=False, strict=False, max_line_length=4096)\n--\n\n"
+     "Sum the calibration values in 'data', any bytes-like object. The data is not copied."},
+    {NULL, NULL, 0, NULL},
+};
+
+static struct PyModuleDef TrebuchetModule = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "trebuchet",
+    .m_doc = "Advent of Code 2023, day 1: sum the first and last digit of each line.",
+    .m_size = 0, // The module has no state of its own, so it's safe to use from any interpreter.
+    .m_methods = TrebuchetMethods,
+};
+
+// Python calls this when you "import trebuchet". The name has to be PyInit_ followed by the module's name.
+PyMODINIT_FUNC PyInit_trebuchet(void)
+{
+    return PyModuleDef_Init(&TrebuchetModule);
+}
@@ -0,0 +1,205 @@
+// This file builds the word automaton described in words.h.
+//
+// Building happens once, at startup. The scanner only ever reads the finished tables.
+
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// string.h used for strlen() and memcpy()
+#include <string.h>
+
+// aoc_runtime.h used for splitting the vocabulary into lines and words
+#include "aoc_runtime.h"
+#include "words.h"
+
+const char *words_build(words_t *words, size_t count, const char *const *spellings, const unsigned char *digits,
+                        size_t *errorIndex)
+{
+    unsigned char classOf[256] = {0}; // Class 0 is every byte that isn't in any word.
+    unsigned classes = 1;
+    size_t maxStates = 1; // The start state, plus (at most) one state per byte of every word.
+
+    if (count > WORDS_MAX_COUNT)
+    {
+        *errorIndex = WORDS_MAX_COUNT;
+        return "too many words";
+    }
+
+    // First pass: check the words, and give each byte that appears in them a class of its own.
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t length = strlen(spellings[i]);
+        *errorIndex = i;
+        if (length == 0)
+            return "empty word";
+        if (length > WORDS_MAX_LENGTH)
+            return "word is too long";
+        if (digits[i] > 9)
+            return "digit must be 0-9";
+        for (size_t j = 0; j < length; j++)
+        {
+            unsigned char byte = (unsigned char)spellings[i][j];
+            if ((byte >= '0' && byte <= '9') || byte == '\n' || byte == '\r') // Those are handled by the scanner itself.
+                return "words can't contain digits or line breaks";
+            if (classOf[byte] == 0)
+                classOf[byte] = (unsigned char)classes++;
+        }
+        maxStates += length;
+    }
+
+    /*
+        Everything the automaton needs goes in one allocation. calloc() fills it with zeros,
+        which is what we want: "next state 0" means "no transition yet", since nothing ever
+        leads back into the start state except failing.
+
+        See: https://en.cppreference.com/w/c/memory/calloc
+    */
+    size_t cells = maxStates * classes;
+    unsigned short *next = calloc(cells + 2 * maxStates, sizeof *next);
+    unsigned char *classCopy = malloc(sizeof classOf);
+    unsigned short *fail = calloc(maxStates, sizeof *fail);  // Only needed while building.
+    unsigned short *queue = calloc(maxStates, sizeof *queue); // Only needed while building.
+    if (next == NULL || classCopy == NULL || fail == NULL || queue == NULL)
+    {
+        free(next);
+        free(classCopy);
+        free(fail);
+        free(queue);
+        *errorIndex = 0;
+        return "out of memory";
+    }
+    unsigned short *longest = next + cells, *shortest = longest + maxStates;
+
+    /*
+        Second pass: build a "trie", a tree where each state is a prefix of some word.
+
+        Every word becomes a path from the start state, one byte per step. Words that share
+        a prefix ("six" and "seven" share "s") share the beginning of their paths.
+
+        See: https://en.wikipedia.org/wiki/Trie
+    */
+    unsigned states = 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t length = strlen(spellings[i]), state = 0;
+        for (size_t j = 0; j < length; j++)
+        {
+            unsigned short *cell = &next[state * classes + classOf[(unsigned char)spellings[i][j]]];
+            if (*cell == 0)
+                *cell = (unsigned short)states++;
+            state = *cell;
+        }
+        unsigned short output = (unsigned short)(length << 4 | digits[i]);
+        if (longest[state] != 0 && longest[state] != output)
+        {
+            free(next);
+            free(classCopy);
+            free(fail);
+            free(queue);
+            *errorIndex = i;
+            return "word is listed twice with different digits";
+        }
+        longest[state] = shortest[state] = output;
+    }
+
+    /*
+        Third pass: fill in the missing transitions, visiting states in order of their depth
+        (a "breadth-first search", which a queue gives us).
+
+        fail[S] is the longest proper suffix of S's prefix that is also a prefix in the trie.
+        When S has no transition for a byte, we take whatever transition fail[S] has. Because
+        fail[S] is shorter than S, it's been visited already, so its row is complete.
+
+        This is also where a state picks up the words that end inside it: "twone" reaches the
+        state for "twon" + "e", whose fail state is "one", so "one" ends there too.
+
+        See: https://en.wikipedia.org/wiki/Breadth-first_search
+    */
+    size_t head = 0, tail = 0;
+    for (unsigned c = 1; c < classes; c++)
+        if (next[c] != 0) // A child of the start state fails back to the start (fail[] is already 0).
+            queue[tail++] = next[c];
+    while (head < tail)
+    {
+        unsigned state = queue[head++], back = fail[state];
+        if (longest[state] == 0) // Not the end of a word itself, so the longest word is the fail state's.
+            longest[state] = longest[back];
+        if (shortest[back] != 0) // A word ending in the fail state is always shorter.
+            shortest[state] = shortest[back];
+        for (unsigned c = 1; c < classes; c++)
+        {
+            unsigned short *cell = &next[state * classes + c];
+            if (*cell != 0)
+            {
+                fail[*cell] = next[back * classes + c];
+                queue[tail++] = *cell;
+            }
+            else
+                *cell = next[back * classes + c];
+        }
+    }
+    free(fail);
+    free(queue);
+
+    memcpy(classCopy, classOf, sizeof classOf);
+    words->states = states;
+    words->classes = classes;
+    words->classOf = classCopy;
+    words->next = next;
+    words->longest = longest;
+    words->shortest = shortest;
+    words->memory = next; // classCopy is freed separately, through words->classOf.
+    return NULL;
+}
+
+const char *words_parse(words_t *words, const char *text, size_t length, unsigned long *errorLine)
+{
+    /*
+        words_build() wants each word as a C string, ending in '\0'. The words are copied into an arena,
+        which makes all of them from one or two calls to malloc(), and frees them all at once at the end.
+    */
+    aoc_arena_t arena;
+    aoc_arena_init(&arena, 0);
+    const char *spellings[WORDS_MAX_COUNT];
+    unsigned char digits[WORDS_MAX_COUNT];
+    unsigned long lineOf[WORDS_MAX_COUNT];
+    size_t count = 0, errorIndex;
+    unsigned long line = 0;
+    const char *error = NULL;
+
+    aoc_lines_t lines;
+    aoc_span_t rest, word, digit, extra;
+    aoc_lines_init(&lines, text, length);
+    while (error == NULL && aoc_lines_next(&lines, &rest))
+    {
+        line++;
+        // Split the line into a word and a digit, separated by blanks.
+        if (!aoc_fields_next(&rest, " \t", &word) || word.data[0] == '#') // Blank lines and comments.
+            continue;
+        if (!aoc_fields_next(&rest, " \t", &digit) || digit.length != 1 || digit.data[0] < '0' || digit.data[0] > '9' ||
+            aoc_fields_next(&rest, " \t", &extra))
+            error = "expected a word and a digit";
+        else if (count == WORDS_MAX_COUNT)
+            error = "too many words";
+        else if ((spellings[count] = aoc_arena_strndup(&arena, word.data, word.length)) == NULL)
+            error = "out of memory";
+        else
+        {
+            digits[count] = (unsigned char)(digit.data[0] - '0');
+            lineOf[count++] = line;
+        }
+    }
+    if (error == NULL && (error = words_build(words, count, spellings, digits, &errorIndex)) != NULL)
+        line = errorIndex < count ? lineOf[errorIndex] : line;
+    aoc_arena_free(&arena); // words_build() doesn't keep pointers to the spellings.
+    *errorLine = line;
+    return error;
+}
+
+void words_free(words_t *words)
+{
+    if (words->memory == NULL) // Static tables: nothing to free.
+        return;
+    free(words->memory);
+    free((void *)words->classOf); // The cast drops 'const', which free() doesn't accept.
+    words->memory = NULL;
+}
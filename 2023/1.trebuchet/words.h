@@ -0,0 +1,80 @@
+// This file declares the "word automaton", which finds spelled-out digits like "one" or "zwei".
+//
+// The words (and the digit each one stands for) come from a vocabulary, loaded at startup.
+// They're compiled into a table that the scanner follows one byte at a time.
+
+#ifndef WORDS_H
+#define WORDS_H
+
+// stddef.h used for size_t
+#include <stddef.h>
+
+/*
+    A vocabulary file can't be longer than this many words, or bytes per word.
+
+    Each word adds at most one state per byte to the automaton, and state numbers are stored in
+    16 bits (see 'next' below), so these limits keep the automaton under 65536 states.
+*/
+#define WORDS_MAX_COUNT 256
+#define WORDS_MAX_LENGTH 64
+
+/*
+    A compiled vocabulary: a "deterministic finite automaton" (DFA) built with the Aho-Corasick algorithm.
+
+    An automaton is a set of numbered "states" plus a table that says, for each state and each byte,
+    which state to go to next. We start in state 0. Being in state S means "the last few bytes spell
+    the start of some word(s)", and the table already knows where to go when a word doesn't continue.
+    So the scanner does one table lookup per byte, no matter how many words there are.
+
+    For example, with the words "one" and "nine", reading "nio" goes: n -> "n", i -> "ni", o -> "o".
+    The last step jumped straight from "ni" to "o", because "nio" isn't the start of any word but "o" is.
+
+    Several words can finish on the same byte ("twone" finishes "one", and "neun" finishes both "neun"
+    and "un"). Of those, only two matter: the longest one starts earliest, so it's the best candidate
+    for the first digit of a line, and the shortest one starts latest, so it's the best candidate for
+    the last digit. Each state records both.
+
+    To keep the table small, bytes that never appear in a word all share one "class" (0), and the
+    table has a column per class instead of per byte. This is called alphabet compression.
+
+    The pointers are const so that a vocabulary can also live in static, read-only tables.
+
+    See: https://en.wikipedia.org/wiki/Aho%E2%80%93Corasick_algorithm
+    See: https://en.wikipedia.org/wiki/Deterministic_finite_automaton
+*/
+typedef struct WORDS
+{
+    unsigned states;                // Number of states. State 0 is the start.
+    unsigned classes;               // Number of byte classes (columns of 'next').
+    const unsigned char *classOf;   // classOf[byte]: the class of each of the 256 bytes.
+    const unsigned short *next;     // next[state * classes + class]: the state to go to.
+    const unsigned short *longest;  // longest[state]: (length << 4 | digit) of the longest word ending here, or 0.
+    const unsigned short *shortest; // shortest[state]: the same, for the shortest word ending here.
+    void *memory;                   // Memory to free() in words_free(), or NULL for static tables.
+} words_t;
+
+/*
+    Compile 'count' words into 'words'. 'spellings[i]' is written as 'digits[i]' (0-9).
+
+    Returns NULL on success. Otherwise, returns a message describing what's wrong, and stores the
+    index of the word it's about in 'errorIndex'. The message is a string constant, so it doesn't
+    need to be freed.
+*/
+const char *words_build(words_t *words, size_t count, const char *const *spellings, const unsigned char *digits,
+                        size_t *errorIndex);
+
+/*
+    Compile a vocabulary file's contents, which has one word per line, followed by its digit:
+
+        # Lines starting with '#' are comments.
+        eins 1
+        zwei 2
+
+    Returns NULL on success. Otherwise, returns a message, and stores the line number in 'errorLine'.
+*/
+const char *words_parse(words_t *words, const char *text, size_t length, unsigned long *errorLine);
+
+// Free the memory used by 'words'.
+void words_free(words_t *words);
+
+#endif // WORDS_H
@@ -0,0 +1,202 @@
+// This file is "aoc_run", one program that runs every day of 2023 at once.
+//
+// Each day is also its own program (like 1.trebuchet/trebuchet), which is the easiest way to work on
+// one puzzle. But checking that the whole year still gives the right answers would mean starting one
+// program per day, each loading its own input. aoc_run links every day's solution as a function instead,
+// loads all the inputs up front, and solves them in parallel, printing how long each one took.
+//
+// Execute like so:
+//
+// ./aoc_run 1 1.trebuchet/basic01.txt
+//
+// OR, with a folder holding an input per day, named after the day (1.txt, 2.txt...):
+//
+// ./aoc_run --dir inputs
+
+// stdio.h used for printing the table
+#include <stdio.h>
+// stdlib.h used for memory allocation and exit codes
+#include <stdlib.h>
+// string.h used for comparing command-line arguments
+#include <string.h>
+
+#include "aoc_runtime.h"
+
+// Each day's header declares its solver functions.
+#include "trebuchet.h"
+
+/*
+    The "registry" of days: a table with one entry per day, saying what to call for each part.
+
+    Adding a day is one line here, plus linking its library in CMakeLists.txt. A part that isn't
+    solved yet is NULL, and gets skipped.
+*/
+typedef struct AOC_DAY
+{
+    const char *day;           // The day's number, as typed on the command line.
+    const char *name;          // The puzzle's name, for the table.
+    aoc_solver_t *parts[2];    // Part 1 and part 2.
+} aoc_day_t;
+
+static const aoc_day_t Days[] = {
+    {"1", "trebuchet", {trebuchet_part1, trebuchet_part2}},
+};
+
+#define DAY_COUNT (sizeof Days / sizeof Days[0])
+#define PART_COUNT 2
+
+static char *Argv0; // The name of this program, for error messages.
+
+[[noreturn]] static void usage(void)
+{
+    (void)fprintf(stderr, "Usage: %s [--threads N] [--dir FOLDER] [DAY FILE]...\n", Argv0);
+    exit(EXIT_FAILURE);
+}
+
+// Find a day by its number, or return DAY_COUNT if there's no such day.
+static size_t find_day(const char *day)
+{
+    size_t i = 0;
+    while (i < DAY_COUNT && strcmp(Days[i].day, day) != 0)
+        i++;
+    return i;
+}
+
+// Everything the tasks share. Each task only writes to its own entries in the arrays.
+typedef struct AOC_RUN
+{
+    const char *paths[DAY_COUNT];                      // Each day's input file, or NULL to skip the day.
+    aoc_input_t inputs[DAY_COUNT];                     // Each day's input, once it's loaded.
+    const char *loadErrors[DAY_COUNT];                 // Why a day's input couldn't be loaded, or NULL.
+    unsigned long long loadTimes[DAY_COUNT];           // How long loading took, in nanoseconds.
+    long long answers[DAY_COUNT * PART_COUNT];         // Each part's answer.
+    const char *errors[DAY_COUNT * PART_COUNT];        // Why a part failed, or NULL.
+    unsigned long long solveTimes[DAY_COUNT * PART_COUNT]; // How long each part took, in nanoseconds.
+} aoc_run_t;
+
+// Task 'index' loads day 'index'.
+static void load_task(void *context, size_t index)
+{
+    aoc_run_t *run = context;
+    if (run->paths[index] == NULL)
+        return;
+    unsigned long long start = aoc_now_ns();
+    run->loadErrors[index] = aoc_input_load(&run->inputs[index], run->paths[index]);
+    run->loadTimes[index] = aoc_now_ns() - start;
+}
+
+// Task 'index' solves part (index % PART_COUNT) of day (index / PART_COUNT).
+static void solve_task(void *context, size_t index)
+{
+    aoc_run_t *run = context;
+    size_t day = index / PART_COUNT;
+    aoc_solver_t *solver = Days[day].parts[index % PART_COUNT];
+    if (run->paths[day] == NULL || run->loadErrors[day] != NULL || solver == NULL)
+        return;
+    unsigned long long start = aoc_now_ns();
+    run->errors[index] = solver(run->inputs[day].data, run->inputs[day].length, &run->answers[index]);
+    run->solveTimes[index] = aoc_now_ns() - start;
+}
+
+int main(int argc, char **argv)
+{
+    Argv0 = argv[0] != NULL ? argv[0] : "aoc_run";
+
+    /*
+        'static' puts the (large, zero-filled) results in the program's data section, rather than
+        on the stack, where big arrays can run out of room.
+    */
+    static aoc_run_t run;
+    unsigned threads = 0; // 0: one per CPU.
+    const char *folder = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            char *end;
+            unsigned long value = strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || value == 0 || value > 1024)
+                usage();
+            threads = (unsigned)value;
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+            folder = argv[++i];
+        else if (argv[i][0] == '-' || i + 1 >= argc) // An option we don't know, or a DAY without a FILE.
+            usage();
+        else
+        {
+            size_t day = find_day(argv[i]);
+            if (day == DAY_COUNT)
+            {
+                (void)fprintf(stderr, "%s: no such day: %s\n", Argv0, argv[i]);
+                return EXIT_FAILURE;
+            }
+            run.paths[day] = argv[++i];
+        }
+    }
+
+    // With --dir, every day that wasn't given a FILE looks for FOLDER/DAY.txt.
+    static char folderPaths[DAY_COUNT][4096];
+    for (size_t i = 0; folder != NULL && i < DAY_COUNT; i++)
+        if (run.paths[i] == NULL)
+        {
+            int written = snprintf(folderPaths[i], sizeof folderPaths[i], "%s/%s.txt", folder, Days[i].day);
+            if (written > 0 && (size_t)written < sizeof folderPaths[i])
+            {
+                FILE *f = fopen(folderPaths[i], "rb"); // Quietly skip days that have no input in the folder.
+                if (f != NULL)
+                {
+                    (void)fclose(f);
+                    run.paths[i] = folderPaths[i];
+                }
+            }
+        }
+
+    // Load every input first, so that the solve times below don't include waiting for the disk.
+    unsigned long long start = aoc_now_ns();
+    (void)aoc_parallel_for(DAY_COUNT, threads, load_task, &run);
+    unsigned long long loaded = aoc_now_ns();
+    unsigned used = aoc_parallel_for(DAY_COUNT * PART_COUNT, threads, solve_task, &run);
+    unsigned long long solved = aoc_now_ns();
+
+    // Print the table. Throughput is the input size over the solve time: how fast the solution chews through input.
+    int status = EXIT_SUCCESS;
+    unsigned long long bytes = 0, busy = 0;
+    (void)printf("%-4s %-16s %-4s %20s %10s %10s %10s\n", "Day", "Name", "Part", "Answer", "Load ms", "Solve ms", "MB/s");
+    for (size_t i = 0; i < DAY_COUNT; i++)
+    {
+        if (run.paths[i] == NULL)
+            continue;
+        if (run.loadErrors[i] != NULL)
+        {
+            (void)printf("%-4s %-16s %-4s %s: %s\n", Days[i].day, Days[i].name, "-", run.loadErrors[i], run.paths[i]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        bytes += run.inputs[i].length;
+        for (size_t part = 0; part < PART_COUNT; part++)
+        {
+            size_t index = i * PART_COUNT + part;
+            if (Days[i].parts[part] == NULL)
+                continue;
+            double ms = (double)run.solveTimes[index] / 1e6;
+            busy += run.solveTimes[index];
+            if (run.errors[index] != NULL)
+            {
+                (void)printf("%-4s %-16s %-4zu %20s %10.3f %10.3f\n", Days[i].day, Days[i].name, part + 1,
+                             run.errors[index], (double)run.loadTimes[i] / 1e6, ms);
+                status = EXIT_FAILURE;
+                continue;
+            }
+            // Bytes per nanosecond is gigabytes per second; times 1000 makes it megabytes per second.
+            double throughput = run.solveTimes[index] != 0 ? (double)run.inputs[i].length * 1e3 / (double)run.solveTimes[index] : 0;
+            (void)printf("%-4s %-16s %-4zu %20lld %10.3f %10.3f %10.1f\n", Days[i].day, Days[i].name, part + 1,
+                         run.answers[index], (double)run.loadTimes[i] / 1e6, ms, throughput);
+        }
+        aoc_input_free(&run.inputs[i]);
+    }
+    (void)printf("Loaded %llu bytes in %.3f ms, solved in %.3f ms on %u thread%s (%.3f ms of solving in total).\n", bytes,
+                 (double)(loaded - start) / 1e6, (double)(solved - loaded) / 1e6, used, used == 1 ? "" : "s",
+                 (double)busy / 1e6);
+    return status;
+}
@@ -0,0 +1,159 @@
+// This file adds results up across processes in a shared file, for aoc_aggregate_add() and aoc_aggregate_read()
+// in aoc_runtime.h.
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // For mmap() and friends. See input.c.
+#endif
+
+// time.h used for nanosleep()
+#include <time.h>
+
+#if !defined(_WIN32)
+#define AOC_HAVE_MMAP
+// fcntl.h used for open()
+#include <fcntl.h>
+// sys/mman.h used for mmap()
+#include <sys/mman.h>
+// sys/stat.h used for fstat()
+#include <sys/stat.h>
+// unistd.h used for ftruncate() and close()
+#include <unistd.h>
+#endif
+
+#include "aoc_runtime.h"
+
+// The first 8 bytes of an aggregate file, so we know we're looking at one: "AOCaggr1" read as a number.
+#define MAGIC 0x31726767614f4341ull
+
+// How many times aoc_aggregate_read() tries to catch the totals between updates, before giving up.
+#define READ_TRIES 1000
+
+/*
+    How aoc_aggregate_read() gets totals that all come from the same moment, while other processes add to them.
+
+    Each total is added to with an atomic add, so no add is ever lost, and nobody waits for a lock. But a
+    reader could see one process's sum without its lines, say. So the file has two "generation" counters
+    as well: 'started' counts the updates that have begun, and 'finished' those that are done. An update
+    adds one to 'started' first, and one to 'finished' last. If a reader sees the same number in 'finished'
+    before it reads the totals as it sees in 'started' after, then no update began or was still going while
+    it read them. Otherwise, it tries again.
+
+    This is a "seqlock", except that the writers don't take turns: they only need the counters to tell
+    the reader whether anyone was busy. The fences make sure the counters and the totals are seen in the
+    order they were written, which ordinary (relaxed) atomics don't promise.
+
+    The numbers are stored as this computer stores them, so the file only means something on this computer.
+
+    See: https://en.wikipedia.org/wiki/Seqlock
+    See: https://www.hpl.hp.com/techreports/2012/HPL-2012-68.pdf (Hans Boehm, "Can Seqlocks Get Along With
+         Programming Language Memory Models?")
+*/
+typedef struct AOC_AGGREGATE
+{
+    atomic_ullong magic;    // MAGIC, once the file has been set up.
+    atomic_ullong started;  // How many updates have begun.
+    atomic_ullong finished; // How many updates are done.
+    atomic_ullong runs;     // The totals: see aoc_totals_t.
+    atomic_ullong bytes;
+    atomic_ullong lines;
+    atomic_llong sum;
+} aoc_aggregate_t;
+
+#if defined(AOC_HAVE_MMAP)
+/*
+    Open and map the aggregate file at 'path', making it if 'create' is true and it isn't there yet.
+
+    A new file is made empty, and then grown to the right size, which fills it with zeros. Several processes
+    may do that at once, and that's fine: they all grow it to the same size. Then the first to see zeros
+    where the magic number goes writes it. Anything else is someone else's file, which we leave alone.
+*/
+static const char *open_aggregate(const char *path, bool create, aoc_aggregate_t **aggregate)
+{
+    int fd = open(path, create ? O_RDWR | O_CREAT : O_RDONLY, 0666);
+    if (fd < 0)
+        return create ? "Unable to open aggregate file" : "No aggregate file there";
+    struct stat info;
+    const char *error = NULL;
+    if (fstat(fd, &info) != 0 || (info.st_size != 0 && (size_t)info.st_size != sizeof(aoc_aggregate_t)))
+        error = "Not an aggregate file";
+    else if (info.st_size == 0 && (!create || ftruncate(fd, sizeof(aoc_aggregate_t)) != 0))
+        error = create ? "Unable to grow aggregate file" : "Not an aggregate file";
+    void *map = MAP_FAILED;
+    if (error == NULL)
+        map = mmap(NULL, sizeof(aoc_aggregate_t), create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd); // The mapping keeps it open.
+    if (error == NULL && map == MAP_FAILED)
+        error = "Unable to map aggregate file";
+    if (error != NULL)
+        return error;
+
+    *aggregate = map;
+    unsigned long long magic = 0;
+    if (create)
+        (void)atomic_compare_exchange_strong(&(*aggregate)->magic, &magic, MAGIC); // 'magic' gets what was there.
+    else
+        magic = atomic_load(&(*aggregate)->magic);
+    if (magic == MAGIC || (create && magic == 0))
+        return NULL;
+    (void)munmap(map, sizeof(aoc_aggregate_t));
+    return "Not an aggregate file";
+}
+#endif
+
+const char *aoc_aggregate_add(const char *path, const aoc_totals_t *add)
+{
+#if defined(AOC_HAVE_MMAP)
+    aoc_aggregate_t *aggregate;
+    const char *error = open_aggregate(path, true, &aggregate);
+    if (error != NULL)
+        return error;
+    atomic_fetch_add_explicit(&aggregate->started, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // Anyone who sees the totals below change sees 'started' change first.
+    atomic_fetch_add_explicit(&aggregate->runs, add->runs, memory_order_relaxed);
+    atomic_fetch_add_explicit(&aggregate->bytes, add->bytes, memory_order_relaxed);
+    atomic_fetch_add_explicit(&aggregate->lines, add->lines, memory_order_relaxed);
+    atomic_fetch_add_explicit(&aggregate->sum, add->sum, memory_order_relaxed);
+    atomic_fetch_add_explicit(&aggregate->finished, 1, memory_order_release); // And 'finished' only after them.
+    (void)munmap(aggregate, sizeof *aggregate); // munmap() doesn't wait for the disk: msync() would.
+    return NULL;
+#else
+    (void)path;
+    (void)add;
+    return "Aggregate files aren't supported on this system";
+#endif
+}
+
+const char *aoc_aggregate_read(const char *path, aoc_totals_t *totals)
+{
+#if defined(AOC_HAVE_MMAP)
+    aoc_aggregate_t *aggregate;
+    const char *error = open_aggregate(path, false, &aggregate);
+    if (error != NULL)
+        return error;
+    error = "An update never finished (did a process die in the middle of one?)";
+    for (int try = 0; try < READ_TRIES; try++)
+    {
+        unsigned long long finished = atomic_load_explicit(&aggregate->finished, memory_order_acquire);
+        totals->runs = atomic_load_explicit(&aggregate->runs, memory_order_relaxed);
+        totals->bytes = atomic_load_explicit(&aggregate->bytes, memory_order_relaxed);
+        totals->lines = atomic_load_explicit(&aggregate->lines, memory_order_relaxed);
+        totals->sum = atomic_load_explicit(&aggregate->sum, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire); // Read 'started' only after the totals.
+        unsigned long long started = atomic_load_explicit(&aggregate->started, memory_order_relaxed);
+        if (started == finished)
+        {
+            totals->generation = finished;
+            error = NULL;
+            break;
+        }
+        struct timespec pause = {.tv_nsec = 1000000}; // An update takes a moment: give it a millisecond.
+        (void)nanosleep(&pause, NULL);
+    }
+    (void)munmap(aggregate, sizeof *aggregate);
+    return error;
+#else
+    (void)path;
+    (void)totals;
+    return "Aggregate files aren't supported on this system";
+#endif
+}
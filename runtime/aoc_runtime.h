@@ -0,0 +1,514 @@
+// This file declares "aoc_runtime", a small library of helpers that every day's solution can use.
+//
+// Almost every Advent of Code puzzle starts the same way: read the input, split it into lines,
+// split the lines into fields, and maybe allocate some memory along the way. Rather than write
+// that again each day (and make the same mistakes each day), it lives here, written once and
+// written to be fast.
+//
+// Link a day's target to aoc_runtime in its CMakeLists.txt, then #include "aoc_runtime.h".
+
+#ifndef AOC_RUNTIME_H
+#define AOC_RUNTIME_H
+
+// stdatomic.h used for the counters in aoc_progress_t
+#include <stdatomic.h>
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+// stdio.h used for FILE, in aoc_timer_print()
+#include <stdio.h>
+
+/* Input loading *************************************************************************************************/
+
+/*
+    How an input was loaded.
+
+    "Mapping" a file (with mmap) asks the operating system to make the file's contents appear in our
+    memory directly. Nothing is copied up front: pages of the file are read in the first time we touch
+    them. It's the fastest way to read a file that's already cached, and costs no extra memory.
+
+    Pipes (like `cat input.txt | ./trebuchet`) can't be mapped, so those are read into a buffer instead.
+
+    See: https://en.wikipedia.org/wiki/Memory-mapped_file
+    See: https://man7.org/linux/man-pages/man2/mmap.2.html
+*/
+typedef enum AOC_INPUT_KIND
+{
+    AocInputBuffered, // Read into a buffer from malloc().
+    AocInputMapped,   // Mapped into memory with mmap().
+    AocInputDirect    // Read into a buffer with O_DIRECT, around the page cache (only aoc_pipeline_run() does this).
+} aoc_input_kind_t;
+
+// An input that's been loaded into memory. Treat the fields as read-only.
+typedef struct AOC_INPUT
+{
+    const unsigned char *data; // The input's bytes.
+    size_t length;             // How many bytes there are.
+    aoc_input_kind_t kind;     // How it was loaded.
+    int fd;                    // The open file descriptor, or -1. Kept open for the lifetime of the input.
+} aoc_input_t;
+
+/*
+    Load all of 'path' into 'input'. If 'path' is NULL, read standard input instead.
+
+    Returns NULL on success. Otherwise, returns a message describing what went wrong.
+*/
+const char *aoc_input_load(aoc_input_t *input, const char *path);
+
+// Release the memory (or mapping) used by 'input'.
+void aoc_input_free(aoc_input_t *input);
+
+/* Binary files **************************************************************************************************/
+
+/*
+    Store 'value' in 'count' bytes (up to 8) at 'bytes', lowest byte first, or read one back.
+
+    CPUs disagree on which order a number's bytes go in memory ("endianness"), so a file written straight
+    from memory on one may read back wrong on another. Picking an order, and sticking to it byte by byte,
+    gives files that read back the same everywhere.
+
+    See: https://en.wikipedia.org/wiki/Endianness
+*/
+void aoc_put_le(unsigned char *bytes, unsigned long long value, int count);
+unsigned long long aoc_get_le(const unsigned char *bytes, int count);
+
+/*
+    Replace the file at 'path' with 'length' bytes from 'data', all at once: they're written to a new file
+    next to it, which is then renamed over it. Anyone reading 'path' meanwhile sees the old file, whole,
+    rather than a half-written new one. Returns NULL on success, or a message describing what went wrong.
+*/
+const char *aoc_file_replace(const char *path, const void *data, size_t length);
+
+/* Lines and fields **********************************************************************************************/
+
+/*
+    A "span" is a pointer and a length: a view of some bytes that live somewhere else.
+
+    Spans are how we split input without copying it. A line is just a span pointing into the
+    loaded input. The catch is that a span isn't a C string: there's no '\0' at the end, so use
+    its length (with functions like memcmp() or printf("%.*s")) rather than strlen() or strcmp().
+
+    See: https://en.cppreference.com/w/cpp/container/span (the same idea, in C++)
+*/
+typedef struct AOC_SPAN
+{
+    const char *data;
+    size_t length;
+} aoc_span_t;
+
+// Walks through the lines of some text. Set it up with aoc_lines_init().
+typedef struct AOC_LINES
+{
+    const char *next; // Start of the next line.
+    const char *end;  // End of the text.
+} aoc_lines_t;
+
+// Start walking the lines of the 'length' bytes at 'data'.
+void aoc_lines_init(aoc_lines_t *lines, const void *data, size_t length);
+
+/*
+    Store the next line in 'line', without its "\n" (or "\r\n"), and return true.
+    Returns false when there are no lines left. A final line without a newline still counts.
+*/
+bool aoc_lines_next(aoc_lines_t *lines, aoc_span_t *line);
+
+/*
+    Split a field off the front of 'rest', and store it in 'field'.
+
+    Fields are separated by any of the characters in 'delimiters'. Runs of delimiters count as one,
+    so "3 blue,  4 red" split on " ," gives "3", "blue", "4", "red". Returns false when 'rest' has no
+    fields left.
+*/
+bool aoc_fields_next(aoc_span_t *rest, const char *delimiters, aoc_span_t *field);
+
+/* Arena allocation **********************************************************************************************/
+
+/*
+    An "arena" (or "bump allocator") hands out memory from big blocks, by moving a pointer forward.
+
+    Allocating is just an addition, much cheaper than malloc(). The trade-off is that you can't free
+    one allocation: you free the whole arena at once. For a puzzle solution, which builds up some data,
+    uses it, and exits, that's exactly what we want.
+
+    See: https://en.wikipedia.org/wiki/Region-based_memory_management
+*/
+typedef struct AOC_ARENA
+{
+    struct AOC_ARENA_BLOCK *block; // The block we're allocating from (which points to the ones before it).
+    size_t used;                   // Bytes used in 'block'.
+    size_t blockSize;              // How big new blocks are, unless an allocation needs more.
+} aoc_arena_t;
+
+// Set up an empty arena. 'blockSize' is how much memory to ask malloc() for at a time (0 for a default).
+void aoc_arena_init(aoc_arena_t *arena, size_t blockSize);
+
+/*
+    Allocate 'size' bytes, aligned to 'alignment' (a power of two, like alignof(double)).
+    Returns NULL if we're out of memory.
+*/
+void *aoc_arena_alloc(aoc_arena_t *arena, size_t size, size_t alignment);
+
+// Copy 'length' bytes into the arena, and add a '\0', making a C string from a span.
+char *aoc_arena_strndup(aoc_arena_t *arena, const char *text, size_t length);
+
+// Free everything allocated from 'arena'. It can be used again afterwards.
+void aoc_arena_free(aoc_arena_t *arena);
+
+/* Timing ********************************************************************************************************/
+
+// The most phases an aoc_timer_t records.
+#define AOC_TIMER_MAX_PHASES 16
+
+/*
+    Times the "phases" of a program, like loading the input and solving it.
+
+    Call aoc_timer_start() once, then aoc_timer_phase() at the end of each phase, with its name.
+*/
+typedef struct AOC_TIMER
+{
+    unsigned long long start;                        // When the current phase started, from aoc_now_ns().
+    unsigned count;                                  // Number of phases recorded.
+    const char *names[AOC_TIMER_MAX_PHASES];         // Each phase's name.
+    unsigned long long nanoseconds[AOC_TIMER_MAX_PHASES]; // How long each phase took.
+} aoc_timer_t;
+
+/*
+    The time, in nanoseconds, since some fixed point in the past.
+
+    The clock is "monotonic": it never jumps backwards (unlike the time of day, which changes when your
+    clock is corrected). Only differences between two readings mean anything.
+
+    See: https://en.wikipedia.org/wiki/Monotonic_function
+*/
+unsigned long long aoc_now_ns(void);
+
+void aoc_timer_start(aoc_timer_t *timer);
+
+// End the current phase, calling it 'name', and start the next one. 'name' must outlive the timer.
+void aoc_timer_phase(aoc_timer_t *timer, const char *name);
+
+// Print a table of the phases to 'out'. If 'bytes' isn't 0, also print how fast that many bytes went by.
+void aoc_timer_print(const aoc_timer_t *timer, FILE *out, unsigned long long bytes);
+
+/* Running in parallel *******************************************************************************************/
+
+/*
+    How many CPUs, and how much memory, this program can use.
+
+    Counting the computer's CPUs isn't enough. In a container (like Docker, or a Kubernetes pod), the
+    computer may have 64 CPUs while we're only allowed 2 CPUs' worth of time. Start 64 threads there,
+    and the kernel lets them all run for a moment, then "throttles" (stops) all of them for the rest of
+    each 100ms period. It's much slower than 2 threads that never stop.
+
+    On Linux, containers are built from "control groups" (cgroups), whose limits we can read from files.
+
+    See: https://docs.kernel.org/admin-guide/cgroup-v2.html
+*/
+typedef struct AOC_LIMITS
+{
+    unsigned cpus;                       // How many threads to run at once: the lowest of the limits below.
+    unsigned long long memory;           // How many bytes of memory we may use (0 if unknown).
+    unsigned hostCpus;                   // The computer's CPUs.
+    unsigned long long hostMemory;       // The computer's memory, in bytes (0 if unknown).
+    unsigned long long cgroupMilliCpus;  // The cgroup's cpu.max quota, in thousandths of a CPU (0 for no limit).
+    unsigned cgroupCpuset;               // The number of CPUs in the cgroup's cpuset.cpus.effective (0 for no limit).
+    unsigned long long cgroupMemory;     // The cgroup's memory.max, in bytes (0 for no limit).
+} aoc_limits_t;
+
+void aoc_limits_read(aoc_limits_t *limits);
+
+// Print 'limits' to 'out', with where each one came from, like aoc_timer_print() does for timers.
+void aoc_limits_print(const aoc_limits_t *limits, FILE *out);
+
+// How many CPUs this program can use (aoc_limits_t's 'cpus'). Always at least 1.
+unsigned aoc_cpu_count(void);
+
+// A task for aoc_parallel_for(): do task number 'index', using whatever 'context' points to.
+typedef void aoc_task_t(void *context, size_t index);
+
+/*
+    Run task(context, 0) through task(context, count - 1), spread across 'threads' threads
+    (0 means one per CPU), and wait for all of them to finish. Returns how many threads were used.
+
+    The tasks run at the same time, in any order, so they must not write to the same memory.
+    Give each task its own slot in an array for its results.
+
+    See: https://en.wikipedia.org/wiki/Thread_pool
+    See: https://en.wikipedia.org/wiki/Fork%E2%80%93join_model
+*/
+unsigned aoc_parallel_for(size_t count, unsigned threads, aoc_task_t *task, void *context);
+
+/*
+    Which CPUs to run threads on, and in which order.
+
+    Left alone, the kernel moves threads from CPU to CPU as it sees fit. Each move leaves behind a cache full
+    of the thread's data, and on a busy computer, threads that share data may end up far apart. "Pinning"
+    each thread to a CPU of its own stops that.
+
+    CPUs aren't all alike. A physical core may run two "hyperthreads", which count as two CPUs but share
+    one core's caches and execution units, and a group of cores shares an L3 cache. So the best order is:
+    one CPU from each core that shares the same L3 cache, then the second hyperthread of each of those
+    cores, and only then another L3 cache's cores. Threads that pass data to each other stay close.
+
+    See: https://en.wikipedia.org/wiki/Processor_affinity
+    See: https://en.wikipedia.org/wiki/CPU_cache#Multi-level_caches
+*/
+#define AOC_MAX_CPUS 1024
+
+typedef struct AOC_PLACEMENT
+{
+    unsigned count;              // How many CPUs are in 'cpus' (0 if we don't know: don't pin anything).
+    unsigned cpus[AOC_MAX_CPUS]; // The CPUs to use, best first. Thread i runs on cpus[i % count].
+    unsigned shared;             // How many of the first CPUs share an L3 cache with cpus[0].
+    unsigned cores;              // How many physical cores they're on (0 if we don't know).
+    unsigned caches;             // How many L3 caches they share (0 if we don't know).
+} aoc_placement_t;
+
+// Find the CPUs we may use, and put them in the best order, from the topology in /sys/devices/system/cpu.
+void aoc_placement_read(aoc_placement_t *placement);
+
+/*
+    Set 'placement' to the CPUs in 'list', in the order given, like "0-3,8,10" (the format that cgroups and
+    `taskset --cpu-list` use). Returns NULL on success, or a message describing what's wrong with 'list'.
+
+    See: https://man7.org/linux/man-pages/man7/cpuset.7.html#FORMATS
+*/
+const char *aoc_placement_parse(aoc_placement_t *placement, const char *list);
+
+// Print 'placement' to 'out', like aoc_limits_print().
+void aoc_placement_print(const aoc_placement_t *placement, FILE *out);
+
+/*
+    Pin the calling thread to the 'count' CPUs in 'cpus': it will only run on those. If 'previous' isn't NULL,
+    the CPUs it could run on before are stored there, so it can be put back. Returns false if it couldn't be
+    pinned (some CPUs may not exist, or this isn't Linux), which is harmless: the thread runs wherever it likes.
+*/
+bool aoc_pin(const unsigned *cpus, unsigned count, aoc_placement_t *previous);
+
+/*
+    Run the calling thread (and any it starts afterwards) at "idle" priority, for both the CPU and the disk:
+    it only gets them when no other program wants them. That's for big jobs that share a computer with
+    programs that have to answer quickly. Returns NULL on success, or a message describing what went wrong.
+
+    Priority isn't everything. Reading a huge file also fills the page cache (the kernel's copy of recently
+    read files), pushing out other programs' files, and uses up memory bandwidth. aoc_pipeline_t's
+    'dropCache' and 'rate' take care of those.
+
+    See: https://man7.org/linux/man-pages/man7/sched.7.html
+    See: https://en.wikipedia.org/wiki/Page_cache
+*/
+const char *aoc_background(void);
+
+/* Progress ******************************************************************************************************/
+
+/*
+    How far a long run has got, for other programs to see while it runs: "trebuchet --watch PID" prints it.
+
+    Printing progress from the workers themselves would slow them down, and clutter the output. Instead,
+    they store a few numbers here after each block, and anyone who wants to know reads them. With
+    aoc_progress_share(), "here" is a page of shared memory that other programs can map too.
+
+    Every counter is atomic, and stored and loaded with memory_order_relaxed: a reader may see the bytes
+    from one block and the lines from the next, but never half of a number, and it costs the workers
+    nothing more than an ordinary store.
+
+    See: https://en.cppreference.com/w/c/atomic/memory_order#Relaxed_ordering
+*/
+typedef struct AOC_PROGRESS
+{
+    unsigned long long magic;   // Says that this is a progress page, to whoever maps it.
+    atomic_ullong started;      // When the run started, from aoc_now_ns().
+    atomic_ullong size;         // How many bytes the input has (0 if we can't tell, like a pipe).
+    atomic_ullong bytes;        // How many bytes have been done.
+    atomic_ullong blocks;       // How many blocks have been done.
+    atomic_ullong lines;        // How many lines have been done.
+    atomic_llong sum;           // The answer so far.
+    atomic_ullong throughput;   // Bytes per second, over the last quarter of a second or so.
+    atomic_bool finished;       // Whether the run is over.
+} aoc_progress_t;
+
+/*
+    Make a progress page in shared memory, named after this process, and point 'progress' at it.
+    Returns NULL on success, or a message describing what went wrong. aoc_progress_unshare() removes it.
+*/
+const char *aoc_progress_share(aoc_progress_t **progress);
+void aoc_progress_unshare(aoc_progress_t *progress);
+
+// Start a run of 'size' bytes (0 if unknown). aoc_pipeline_run() calls this.
+void aoc_progress_start(aoc_progress_t *progress, unsigned long long size);
+
+// Write one line about 'progress' to the file descriptor 'fd'. It's async-signal-safe: a signal handler may call it.
+void aoc_progress_write(const aoc_progress_t *progress, int fd);
+
+/*
+    Write 'progress' to standard error whenever this process gets the signal SIGUSR1, as in `kill -USR1 PID`.
+
+    See: https://man7.org/linux/man-pages/man7/signal.7.html
+*/
+void aoc_progress_signal(const aoc_progress_t *progress);
+
+/*
+    Write the progress of process 'pid' to 'fd' every second, until its run finishes or it exits. The process
+    must have called aoc_progress_share(). Returns NULL on success, or a message describing what went wrong.
+*/
+const char *aoc_progress_watch(long pid, int fd);
+
+/* Aggregates ****************************************************************************************************/
+
+/*
+    Results added up across many processes, in a small file that each of them maps into memory (an "aggregate
+    file"). Each process adds its results with atomic adds, without waiting for the others, and anyone can
+    read the totals at any time, without adding anything up themselves. See aggregate.c.
+*/
+typedef struct AOC_TOTALS
+{
+    unsigned long long runs;       // How many processes added their results.
+    unsigned long long bytes;      // How many bytes they read.
+    unsigned long long lines;      // How many lines they were.
+    long long sum;                 // The sum of their sums.
+    unsigned long long generation; // For aoc_aggregate_read(): how many updates the totals include.
+} aoc_totals_t;
+
+/*
+    Add 'add' to the totals in the aggregate file at 'path', making the file if it isn't there yet.
+    Returns NULL on success, or a message describing what went wrong.
+*/
+const char *aoc_aggregate_add(const char *path, const aoc_totals_t *add);
+
+/*
+    Read the totals in the aggregate file at 'path' into 'totals', all from the same moment, even while other
+    processes add to them. Returns NULL on success, or a message describing what went wrong.
+*/
+const char *aoc_aggregate_read(const char *path, aoc_totals_t *totals);
+
+/* Pipeline ******************************************************************************************************/
+
+/*
+    A "block" of input: some whole lines, handed to a worker thread by aoc_pipeline_run() or aoc_pipeline_fan_in().
+*/
+typedef struct AOC_BLOCK
+{
+    const unsigned char *data;   // The block's bytes.
+    size_t length;               // How many there are.
+    unsigned long long offset;   // Where data[0] is in the whole input.
+    unsigned long long index;    // Which block of its input this is: 0 for the first, 1 for the next...
+    size_t source;               // Which input it's from, with aoc_pipeline_fan_in() (0 otherwise).
+    unsigned worker;             // Which worker scans it, 0 to 'workers' - 1, for results kept per worker.
+    void *result;                // Room for the worker's result ('resultSize' bytes), read again by 'merge'.
+} aoc_block_t;
+
+/*
+    How aoc_pipeline_run() reads a regular file. Pipes can only be read.
+
+    Mapping is fastest when the file is already in the page cache. But a huge file that isn't, and that
+    we'll only read once, would push everything else out of the cache on its way through, and then be
+    thrown out itself. "Direct" I/O (O_DIRECT) reads it from the disk straight into our buffers instead,
+    without going through the cache. AocIoAuto checks how much of the file is cached, and chooses.
+
+    See: https://man7.org/linux/man-pages/man2/open.2.html (search for O_DIRECT)
+*/
+typedef enum AOC_IO
+{
+    AocIoAuto,  // Map the file if it's mostly cached, or small. Otherwise, read it directly.
+    AocIoMap,   // Always map it.
+    AocIoRead,  // Always read() it, through the page cache, like a pipe.
+    AocIoDirect // Always read it directly (or through the cache, if the file system can't do direct I/O).
+} aoc_io_t;
+
+/*
+    A pipeline splits an input into blocks of whole lines, and works on several blocks at once.
+
+    One thread (the one that calls aoc_pipeline_run) reads the input, and 'workers' other threads each
+    take the next block, and call 'work' on it. Then 'merge' is called for each block, strictly in order,
+    one at a time, so it can add the blocks' results together as if the input had been read start to end.
+
+    Regular files are mapped into memory a "window" (a block) at a time (see aoc_io_t for the exceptions).
+    Anything else, like a pipe, is read into a "ring" of 'depth' buffers that are used over and over again.
+    Either way, at most 'depth' blocks are in memory at once, so a huge input doesn't need a huge amount of memory.
+
+    See: https://en.wikipedia.org/wiki/Pipeline_(computing)
+    See: https://en.wikipedia.org/wiki/Circular_buffer
+*/
+typedef struct AOC_PIPELINE
+{
+    // Settings. aoc_pipeline_size() picks good ones for this computer.
+    unsigned workers; // How many worker threads to start.
+    unsigned depth;   // How many blocks can be in memory at once (at least 2).
+    size_t blockSize; // Roughly how many bytes are in each block (more if a line is longer).
+    aoc_io_t io;      // How to read regular files.
+    /*
+        Which CPUs to pin threads to, or NULL to leave them alone. Worker i is pinned to cpus[i % count], and the
+        reading thread (the caller) to the CPUs that share an L3 cache with the first worker, until the run ends.
+    */
+    const aoc_placement_t *placement;
+    unsigned long long rate; // Hand out at most this many bytes per second, on average (0 for no limit).
+    bool dropCache;          // Drop each block's pages from the page cache once it's merged. See aoc_background().
+    aoc_progress_t *progress; // Where to show how far we've got, or NULL. 'merge' should update its lines and sum.
+    bool tee;                 // Copy the input to standard output, unchanged, as it's read (see forward() in pipeline.c).
+    /*
+        When to stop handing out blocks, from aoc_now_ns() (0: never). The blocks already handed out are still
+        merged, so the results are exactly those of the input up to there. See expired() in pipeline.c.
+    */
+    unsigned long long deadline;
+
+    // What to do. 'context' is passed to every function.
+    void *context;
+    size_t resultSize; // How many bytes each block's 'result' needs.
+    /*
+        Called by the reading thread, in order, with some bytes from the start of a block. Returns how many of
+        them are whole lines (0 if none are). Not called on the end of the input, which is always a block's end.
+        'source' says which input the bytes are from, with aoc_pipeline_fan_in(), and is 0 otherwise.
+    */
+    size_t (*split)(void *context, size_t source, const unsigned char *data, size_t length);
+    void (*work)(void *context, aoc_block_t *block); // Called by a worker thread, with a block to work on.
+    bool (*merge)(void *context, aoc_block_t *block); // Called in block order. Return false to stop early.
+
+    // Filled in by aoc_pipeline_run().
+    aoc_input_kind_t kind;      // Whether the input was mapped, read, or read directly.
+    unsigned sampled, resident; // For AocIoAuto: how many of the file's pages were checked, and how many were cached.
+    unsigned long long blocks;  // How many blocks were merged.
+    unsigned long long bytes;   // How many bytes were in them.
+    unsigned long long waited;  // How many nanoseconds the reading thread waited, to keep to 'rate'.
+    bool zeroCopy;              // With 'tee': whether all of it was copied with tee() or splice(), instead of write().
+    size_t failed;              // With aoc_pipeline_fan_in(): which input couldn't be opened or read, if one couldn't.
+    bool expired;               // Whether the 'deadline' passed before the end of the input.
+} aoc_pipeline_t;
+
+/*
+    Choose the workers, depth and block size for 'limits': a worker per CPU we may use, two blocks per
+    worker (so there's always another ready), and blocks small enough that all of them together stay well
+    within our memory limit. Returns 'pipeline' with those set, and everything else zero.
+*/
+void aoc_pipeline_size(aoc_pipeline_t *pipeline, const aoc_limits_t *limits);
+
+/*
+    Run 'pipeline' on the file at 'path' (or standard input, if 'path' is NULL).
+
+    Returns NULL when every block has been merged (or 'merge' stopped early). Otherwise, returns a message
+    describing what went wrong.
+*/
+const char *aoc_pipeline_run(aoc_pipeline_t *pipeline, const char *path);
+
+/*
+    Run 'pipeline' on the 'count' files at 'paths' at once, usually FIFOs that other programs write lines into.
+    Whichever have something to read are read (with epoll, on Linux), and each is cut into blocks of its own
+    lines, with a block's 'source' saying which. 'merge' gets each input's blocks in order, but the inputs'
+    blocks are mixed together. Standard input, 'io' and 'tee' aren't used, and 'rate' applies to each input.
+
+    Returns NULL when every block has been merged (or 'merge' stopped early). Otherwise, returns a message
+    describing what went wrong, and 'failed' says which input it was about.
+*/
+const char *aoc_pipeline_fan_in(aoc_pipeline_t *pipeline, const char *const *paths, size_t count);
+
+/* Solvers *******************************************************************************************************/
+
+/*
+    The shape of one part of one day's solution, so aoc_run can call every day the same way.
+
+    It reads the 'length' bytes of input at 'data', and stores the answer in 'answer'. Returns NULL on
+    success, or a message describing what went wrong. It must be safe to call from several threads at once.
+*/
+typedef const char *aoc_solver_t(const unsigned char *data, size_t length, long long *answer);
+
+#endif // AOC_RUNTIME_H
@@ -0,0 +1,106 @@
+// This file implements the arena (bump allocator) declared in aoc_runtime.h.
+
+// stddef.h used for max_align_t
+#include <stddef.h>
+// stdint.h used for uintptr_t
+#include <stdint.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// string.h used for memcpy()
+#include <string.h>
+
+#include "aoc_runtime.h"
+
+// How much memory a block holds, if aoc_arena_init() isn't told.
+#define DEFAULT_BLOCK_SIZE (1 << 16)
+
+/*
+    Each block starts with this header, followed by its memory.
+
+    Blocks form a linked list, newest first, so freeing the arena is a walk down the list.
+    'max_align_t' in the union makes the memory after the header suitably aligned for anything.
+*/
+typedef struct AOC_ARENA_BLOCK
+{
+    union
+    {
+        struct
+        {
+            struct AOC_ARENA_BLOCK *previous;
+            size_t capacity;
+        };
+        max_align_t align;
+    };
+    unsigned char memory[];
+} aoc_arena_block_t;
+
+void aoc_arena_init(aoc_arena_t *arena, size_t blockSize)
+{
+    arena->block = NULL;
+    arena->used = 0;
+    arena->blockSize = blockSize != 0 ? blockSize : DEFAULT_BLOCK_SIZE;
+}
+
+/*
+    How many bytes to skip so that 'p' becomes a multiple of 'alignment'. Because alignment is a power
+    of two, it has exactly one bit set, and "alignment - 1" is all the bits below it.
+
+    See: https://en.wikipedia.org/wiki/Data_structure_alignment#Computing_padding
+*/
+static size_t padding(const void *p, size_t alignment)
+{
+    return (size_t)(-(uintptr_t)p & (alignment - 1));
+}
+
+void *aoc_arena_alloc(aoc_arena_t *arena, size_t size, size_t alignment)
+{
+    aoc_arena_block_t *block = arena->block;
+    if (block != NULL)
+    {
+        size_t start = arena->used + padding(block->memory + arena->used, alignment);
+        if (start <= block->capacity && size <= block->capacity - start)
+        {
+            arena->used = start + size; // This is the whole cost of allocating, most of the time.
+            return block->memory + start;
+        }
+    }
+
+    // Doesn't fit: start a new block. A big allocation gets a block of its own size, with room to align it.
+    if (size > (size_t)-1 - sizeof *block - alignment)
+        return NULL;
+    size_t capacity = size + alignment > arena->blockSize ? size + alignment : arena->blockSize;
+    aoc_arena_block_t *fresh = malloc(sizeof *fresh + capacity);
+    if (fresh == NULL)
+        return NULL;
+    fresh->previous = block;
+    fresh->capacity = capacity;
+    arena->block = fresh;
+
+    size_t start = padding(fresh->memory, alignment);
+    arena->used = start + size;
+    return fresh->memory + start;
+}
+
+char *aoc_arena_strndup(aoc_arena_t *arena, const char *text, size_t length)
+{
+    if (length == (size_t)-1)
+        return NULL;
+    char *copy = aoc_arena_alloc(arena, length + 1, 1);
+    if (copy != NULL)
+    {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+void aoc_arena_free(aoc_arena_t *arena)
+{
+    while (arena->block != NULL)
+    {
+        aoc_arena_block_t *previous = arena->block->previous;
+        free(arena->block);
+        arena->block = previous;
+    }
+    arena->used = 0;
+}
@@ -0,0 +1,54 @@
+// This file makes a program polite to the others on its computer, for aoc_background() in aoc_runtime.h.
+
+// See limits.c: _GNU_SOURCE is for SCHED_IDLE and syscall().
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#if defined(__linux__)
+// sched.h used for sched_setscheduler() and SCHED_IDLE
+#include <sched.h>
+// sys/syscall.h used for SYS_ioprio_set
+#include <sys/syscall.h>
+// unistd.h used for syscall()
+#include <unistd.h>
+#endif
+
+#include "aoc_runtime.h"
+
+#if defined(__linux__)
+/*
+    The C library has no ioprio_set() function, so we make the system call ourselves, with these numbers
+    from the kernel's include/uapi/linux/ioprio.h. A priority is a class, shifted up 13 bits, plus a level.
+
+    See: https://man7.org/linux/man-pages/man2/ioprio_set.2.html
+*/
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+#endif
+
+const char *aoc_background(void)
+{
+#if defined(__linux__)
+    /*
+        SCHED_IDLE threads only get a CPU when nothing else wants it: less than even the "nicest" normal
+        thread. Threads started afterwards inherit it, so call this before starting any.
+
+        See: https://man7.org/linux/man-pages/man7/sched.7.html
+    */
+    struct sched_param parameters = {.sched_priority = 0};
+    if (sched_setscheduler(0, SCHED_IDLE, &parameters) != 0)
+        return "Unable to set idle CPU priority";
+
+    /*
+        The "idle" I/O class does the same for the disk: our reads wait until nobody else is using it.
+        Only some I/O schedulers (like BFQ) take any notice, but it's harmless with the others.
+    */
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0)
+        return "Unable to set idle I/O priority";
+    return NULL;
+#else
+    return "Idle priority is only supported on Linux";
+#endif
+}
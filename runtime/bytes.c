@@ -0,0 +1,65 @@
+// This file reads and writes binary files, for aoc_put_le() and friends in aoc_runtime.h.
+
+// stdio.h used for fopen(), fwrite() and rename()
+#include <stdio.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// string.h used for strlen() and memcpy()
+#include <string.h>
+
+#include "aoc_runtime.h"
+
+void aoc_put_le(unsigned char *bytes, unsigned long long value, int count)
+{
+    for (int i = 0; i < count; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+}
+
+unsigned long long aoc_get_le(const unsigned char *bytes, int count)
+{
+    unsigned long long value = 0;
+    for (int i = 0; i < count; i++)
+        value |= (unsigned long long)bytes[i] << (8 * i);
+    return value;
+}
+
+const char *aoc_file_replace(const char *path, const void *data, size_t length)
+{
+    // The temporary file goes next to 'path', because rename() can't move a file to another file system.
+    size_t pathLength = strlen(path);
+    char *temporary = malloc(pathLength + sizeof ".new");
+    if (temporary == NULL)
+        return "Out of memory";
+    memcpy(temporary, path, pathLength);
+    memcpy(temporary + pathLength, ".new", sizeof ".new");
+
+    const char *error = NULL;
+    FILE *out = fopen(temporary, "wb");
+    if (out == NULL)
+        error = "Unable to create file";
+    else
+    {
+        bool failed = fwrite(data, 1, length, out) != length;
+        failed |= fclose(out) != 0; // fclose() writes whatever is still buffered, so it can fail too.
+        if (failed)
+            error = "Unable to write file";
+    }
+
+    /*
+        On POSIX systems, rename() replaces 'path' in one step: anyone opening it gets the old file or the new
+        one. Windows' rename() won't replace a file that exists, so there, the old one is removed first, and
+        for a moment there's neither.
+
+        See: https://pubs.opengroup.org/onlinepubs/9699919799/functions/rename.html
+    */
+#if defined(_WIN32)
+    if (error == NULL)
+        (void)remove(path);
+#endif
+    if (error == NULL && rename(temporary, path) != 0)
+        error = "Unable to replace file";
+    if (error != NULL)
+        (void)remove(temporary);
+    free(temporary);
+    return error;
+}
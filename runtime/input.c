@@ -0,0 +1,203 @@
+// This file loads a whole input into memory, as fast as the operating system lets us.
+
+/*
+    Ask the C library for the POSIX functions (open, fstat, mmap...) as well as the standard C ones.
+    This has to come before any #include.
+
+    See: https://man7.org/linux/man-pages/man7/feature_test_macros.7.html
+*/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// errno.h used for errno and EINTR
+#include <errno.h>
+// stdio.h used for stdin and fread()
+#include <stdio.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+
+#if defined(_WIN32)
+// fcntl.h and io.h used to switch stdin to binary mode
+#include <fcntl.h>
+#include <io.h>
+#else
+#define AOC_HAVE_MMAP
+// fcntl.h used for open()
+#include <fcntl.h>
+// sys/mman.h used for mmap()
+#include <sys/mman.h>
+// sys/stat.h used for fstat()
+#include <sys/stat.h>
+// unistd.h used for read() and close()
+#include <unistd.h>
+#endif
+
+#include "aoc_runtime.h"
+
+// How much to read at a time, and how big a buffer starts out. Doubling from here keeps the number of copies small.
+#define READ_CHUNK (1 << 16)
+
+#if !defined(AOC_HAVE_MMAP)
+// Read everything from 'f' into a buffer from malloc(), doubling the buffer whenever it fills up (see load_fd()).
+static const char *read_stream(aoc_input_t *input, FILE *f)
+{
+    size_t capacity = READ_CHUNK, used = 0, got;
+    unsigned char *buffer = malloc(capacity), *bigger;
+    if (buffer == NULL)
+        return "Out of memory";
+    while ((got = fread(buffer + used, 1, capacity - used, f)) > 0)
+        if ((used += got) == capacity)
+        {
+            if (capacity > (size_t)-1 / 2 || !(bigger = realloc(buffer, capacity *= 2)))
+            {
+                free(buffer);
+                return "Out of memory";
+            }
+            buffer = bigger;
+        }
+    if (ferror(f))
+    {
+        free(buffer);
+        return "Unable to read input";
+    }
+    input->data = buffer;
+    input->length = used;
+    input->kind = AocInputBuffered;
+    return NULL;
+}
+#else
+/*
+    Load from an open file descriptor: map it if it's a regular file, and read it otherwise.
+
+    Mapping a file of size 0 fails, so empty files are "read" instead (which is instant).
+*/
+static const char *load_fd(aoc_input_t *input, int fd)
+{
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        return "Unable to read input";
+    input->fd = fd;
+    if (S_ISREG(info.st_mode) && info.st_size > 0 && (unsigned long long)info.st_size <= (size_t)-1)
+    {
+        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            /*
+                Tell the kernel that we'll read the file from start to end, once. It responds by reading
+                further ahead of us, so the next pages are (usually) already there when we need them.
+
+                See: https://man7.org/linux/man-pages/man3/posix_madvise.3.html
+            */
+            (void)posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+            input->data = data;
+            input->length = (size_t)info.st_size;
+            input->kind = AocInputMapped;
+            return NULL;
+        }
+    }
+
+    /*
+        Not a regular file (or mapping failed), so read() it into a buffer that doubles whenever it fills up.
+
+        Doubling means each byte is copied (by realloc) at most a couple of times on average, no matter how
+        big the input is, where growing by a fixed amount would copy it over and over again.
+
+        See: https://en.wikipedia.org/wiki/Dynamic_array#Geometric_expansion_and_amortized_cost
+    */
+    size_t capacity = READ_CHUNK, used = 0;
+    unsigned char *buffer = malloc(capacity), *bigger;
+    if (buffer == NULL)
+        return "Out of memory";
+    for (;;)
+    {
+        if (used == capacity)
+        {
+            if (capacity > (size_t)-1 / 2 || !(bigger = realloc(buffer, capacity *= 2)))
+            {
+                free(buffer);
+                return "Out of memory";
+            }
+            buffer = bigger;
+        }
+        ssize_t got = read(fd, buffer + used, capacity - used);
+        if (got == 0)
+            break;
+        if (got < 0)
+        {
+            if (errno == EINTR) // Interrupted by a signal before reading anything: just try again.
+                continue;
+            free(buffer);
+            return "Unable to read input";
+        }
+        used += (size_t)got;
+    }
+    input->data = buffer;
+    input->length = used;
+    input->kind = AocInputBuffered;
+    return NULL;
+}
+#endif
+
+const char *aoc_input_load(aoc_input_t *input, const char *path)
+{
+    input->data = NULL;
+    input->length = 0;
+    input->kind = AocInputBuffered;
+    input->fd = -1;
+
+#if defined(AOC_HAVE_MMAP)
+    if (path == NULL)
+    {
+        /*
+            Standard input is file descriptor 0. We don't keep it in input->fd, because closing it isn't ours to do.
+            If it was redirected from a file (`./trebuchet < input.txt`), it can still be mapped.
+        */
+        const char *error = load_fd(input, STDIN_FILENO);
+        input->fd = -1;
+        return error;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return "Unable to open file";
+    const char *error = load_fd(input, fd);
+    if (error != NULL)
+    {
+        (void)close(fd);
+        input->fd = -1;
+    }
+    return error;
+#else
+    if (path == NULL)
+    {
+#if defined(_WIN32)
+        // On Windows, stdin starts in "text" mode, which changes "\r\n" into "\n". We want the real bytes.
+        (void)_setmode(_fileno(stdin), _O_BINARY);
+#endif
+        return read_stream(input, stdin);
+    }
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return "Unable to open file";
+    const char *error = read_stream(input, f);
+    (void)fclose(f);
+    return error;
+#endif
+}
+
+void aoc_input_free(aoc_input_t *input)
+{
+#if defined(AOC_HAVE_MMAP)
+    if (input->kind == AocInputMapped)
+        (void)munmap((void *)input->data, input->length);
+    else
+        free((void *)input->data);
+    if (input->fd >= 0)
+        (void)close(input->fd);
+#else
+    free((void *)input->data); // The cast drops 'const', which free() doesn't accept.
+#endif
+    input->data = NULL;
+    input->length = 0;
+    input->fd = -1;
+}
@@ -0,0 +1,183 @@
+// This file works out how many CPUs and how much memory we're allowed to use, for aoc_limits_read().
+
+/*
+    _GNU_SOURCE asks for Linux's own functions too, like sched_getaffinity(). It includes
+    everything that _POSIX_C_SOURCE does (see input.c).
+*/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#elif !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+// stdio.h used for reading the cgroup files
+#include <stdio.h>
+// stdlib.h used for getenv()
+#include <stdlib.h>
+// string.h used for strcspn(), strlen() and strrchr()
+#include <string.h>
+
+#if defined(_WIN32)
+// windows.h used for GetSystemInfo() and GlobalMemoryStatusEx()
+#include <windows.h>
+#else
+// unistd.h used for sysconf()
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+// sched.h used for sched_getaffinity()
+#include <sched.h>
+#endif
+
+#include "aoc_runtime.h"
+#include "sysfs.h"
+
+#if defined(__linux__)
+/*
+    Read the limits set by one cgroup folder into 'limits', keeping whichever limit is lower.
+
+    cpu.max is "QUOTA PERIOD": the cgroup may use QUOTA microseconds of CPU time every PERIOD microseconds,
+    so QUOTA / PERIOD CPUs' worth, on average. If it's "max", there's no limit. memory.max is a number of
+    bytes, or "max". cpuset.cpus.effective lists the CPUs that the cgroup may run on.
+
+    See: https://docs.kernel.org/admin-guide/cgroup-v2.html#cpu-interface-files
+    See: https://docs.kernel.org/admin-guide/cgroup-v2.html#memory-interface-files
+*/
+static void read_cgroup(const char *folder, aoc_limits_t *limits)
+{
+    char line[256];
+    unsigned long long quota, period;
+    if (aoc_read_line(folder, "cpu.max", line, sizeof line) && sscanf(line, "%llu %llu", &quota, &period) == 2 && period > 0)
+    {
+        unsigned long long milli = quota * 1000 / period;
+        if (limits->cgroupMilliCpus == 0 || milli < limits->cgroupMilliCpus)
+            limits->cgroupMilliCpus = milli > 0 ? milli : 1;
+    }
+    unsigned long long bytes;
+    if (aoc_read_line(folder, "memory.max", line, sizeof line) && sscanf(line, "%llu", &bytes) == 1)
+        if (limits->cgroupMemory == 0 || bytes < limits->cgroupMemory)
+            limits->cgroupMemory = bytes;
+    aoc_placement_t cpus;
+    if (limits->cgroupCpuset == 0 && aoc_read_line(folder, "cpuset.cpus.effective", line, sizeof line) &&
+        aoc_placement_parse(&cpus, line) == NULL)
+        limits->cgroupCpuset = cpus.count;
+}
+
+/*
+    Find our cgroup, and read its limits and its parents' (a parent's limit applies to everything inside it).
+
+    /proc/self/cgroup has a line "0::/path" for cgroup v2, and the folder is /sys/fs/cgroup/path.
+    The environment variable AOC_CGROUP can name a folder to read instead, which is handy for testing.
+
+    See: https://man7.org/linux/man-pages/man7/cgroups.7.html
+*/
+static void read_cgroups(aoc_limits_t *limits)
+{
+    char folder[AOC_PATH_LENGTH];
+    const char *override = getenv("AOC_CGROUP");
+    if (override != NULL)
+    {
+        read_cgroup(override, limits);
+        return;
+    }
+
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (f == NULL)
+        return;
+    char line[AOC_PATH_LENGTH];
+    bool found = false;
+    while (!found && fgets(line, sizeof line, f) != NULL)
+        found = strncmp(line, "0::", 3) == 0;
+    (void)fclose(f);
+    if (!found)
+        return;
+    line[strcspn(line, "\n")] = '\0';
+    if (snprintf(folder, sizeof folder, "/sys/fs/cgroup%s", line + 3) >= (int)sizeof folder)
+        return;
+
+    // Walk up from our cgroup to the root, by cutting off the last "/name" each time.
+    size_t root = strlen("/sys/fs/cgroup");
+    for (;;)
+    {
+        read_cgroup(folder, limits);
+        char *slash = strrchr(folder, '/');
+        if (slash == NULL || (size_t)(slash - folder) < root)
+            break;
+        *slash = '\0';
+    }
+}
+#endif
+
+void aoc_limits_read(aoc_limits_t *limits)
+{
+    *limits = (aoc_limits_t){0};
+
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    limits->hostCpus = info.dwNumberOfProcessors;
+    MEMORYSTATUSEX memory = {.dwLength = sizeof memory};
+    if (GlobalMemoryStatusEx(&memory))
+        limits->hostMemory = memory.ullTotalPhys;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN); // "Online" processors: the ones that are switched on and usable.
+    limits->hostCpus = cpus > 0 ? (unsigned)cpus : 1;
+#if defined(_SC_PHYS_PAGES)
+    long pages = sysconf(_SC_PHYS_PAGES), pageSize = sysconf(_SC_PAGESIZE);
+    if (pages > 0 && pageSize > 0)
+        limits->hostMemory = (unsigned long long)pages * (unsigned long long)pageSize;
+#endif
+#endif
+
+    limits->cpus = limits->hostCpus;
+    limits->memory = limits->hostMemory;
+
+#if defined(__linux__)
+    /*
+        The "affinity mask" is the set of CPUs this process may run on (`taskset` changes it).
+        A container's cpuset shows up here too, even without reading the cgroup files.
+
+        See: https://man7.org/linux/man-pages/man2/sched_setaffinity.2.html
+    */
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof set, &set) == 0 && CPU_COUNT(&set) > 0 && (unsigned)CPU_COUNT(&set) < limits->cpus)
+        limits->cpus = (unsigned)CPU_COUNT(&set);
+
+    read_cgroups(limits);
+    if (limits->cgroupCpuset != 0 && limits->cgroupCpuset < limits->cpus)
+        limits->cpus = limits->cgroupCpuset;
+    if (limits->cgroupMilliCpus != 0)
+    {
+        // Round down: with a quota of 1.5 CPUs, 2 busy threads would use it up early, and be throttled every period.
+        unsigned quota = (unsigned)(limits->cgroupMilliCpus / 1000);
+        if (quota == 0)
+            quota = 1;
+        if (quota < limits->cpus)
+            limits->cpus = quota;
+    }
+    if (limits->cgroupMemory != 0 && (limits->memory == 0 || limits->cgroupMemory < limits->memory))
+        limits->memory = limits->cgroupMemory;
+#endif
+    if (limits->cpus == 0)
+        limits->cpus = 1;
+}
+
+unsigned aoc_cpu_count(void)
+{
+    aoc_limits_t limits;
+    aoc_limits_read(&limits);
+    return limits.cpus;
+}
+
+void aoc_limits_print(const aoc_limits_t *limits, FILE *out)
+{
+    (void)fprintf(out, "%-12s %u (computer %u", "cpus", limits->cpus, limits->hostCpus);
+    if (limits->cgroupMilliCpus != 0)
+        (void)fprintf(out, ", cgroup quota %llu.%03llu", limits->cgroupMilliCpus / 1000, limits->cgroupMilliCpus % 1000);
+    if (limits->cgroupCpuset != 0)
+        (void)fprintf(out, ", cgroup cpuset %u", limits->cgroupCpuset);
+    (void)fprintf(out, ")\n%-12s %llu bytes (computer %llu", "memory", limits->memory, limits->hostMemory);
+    if (limits->cgroupMemory != 0)
+        (void)fprintf(out, ", cgroup %llu", limits->cgroupMemory);
+    (void)fprintf(out, ")\n");
+}
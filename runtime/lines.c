@@ -0,0 +1,54 @@
+// This file splits text into lines and fields, without copying any of it.
+
+// string.h used for memchr() and strchr()
+#include <string.h>
+
+#include "aoc_runtime.h"
+
+void aoc_lines_init(aoc_lines_t *lines, const void *data, size_t length)
+{
+    lines->next = data;
+    lines->end = lines->next + length;
+}
+
+bool aoc_lines_next(aoc_lines_t *lines, aoc_span_t *line)
+{
+    if (lines->next >= lines->end)
+        return false;
+
+    /*
+        memchr() finds the next newline. The C library's version is usually written to check many bytes
+        at a time (with the same SIMD instructions as trebuchet.c), so it's hard to beat with a loop.
+
+        See: https://en.cppreference.com/w/c/string/byte/memchr
+    */
+    const char *start = lines->next, *newline = memchr(start, '\n', (size_t)(lines->end - start));
+    const char *stop = newline != NULL ? newline : lines->end;
+    lines->next = newline != NULL ? newline + 1 : lines->end;
+    if (stop > start && stop[-1] == '\r') // Windows line endings.
+        stop--;
+    line->data = start;
+    line->length = (size_t)(stop - start);
+    return true;
+}
+
+bool aoc_fields_next(aoc_span_t *rest, const char *delimiters, aoc_span_t *field)
+{
+    const char *p = rest->data, *end = p + rest->length;
+    while (p < end && strchr(delimiters, *p) != NULL && *p != '\0') // strchr() also "finds" the '\0' at the end.
+        p++;
+    if (p == end)
+    {
+        rest->data = end;
+        rest->length = 0;
+        return false;
+    }
+    const char *start = p;
+    while (p < end && (strchr(delimiters, *p) == NULL || *p == '\0'))
+        p++;
+    field->data = start;
+    field->length = (size_t)(p - start);
+    rest->data = p;
+    rest->length = (size_t)(end - p);
+    return true;
+}
@@ -0,0 +1,1005 @@
+// This file runs an input through a pipeline of threads, for aoc_pipeline_run() and aoc_pipeline_fan_in()
+// in aoc_runtime.h.
+//
+// The reading thread fills "slots" with blocks, workers scan them, and whoever finishes the oldest
+// block merges it. A slot goes round a cycle: free -> ready -> busy -> done -> (merged) -> free.
+
+#if defined(__linux__)
+#define _GNU_SOURCE // For O_DIRECT, mincore(), tee(), splice() and epoll, as well as everything below. See limits.c.
+#elif !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // For mmap() and friends. See input.c.
+#endif
+
+// errno.h used for errno and EINTR
+#include <errno.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// string.h used for memcpy()
+#include <string.h>
+// threads.h used for threads, mutexes and condition variables
+#include <threads.h>
+// time.h used for timespec_get()
+#include <time.h>
+
+#if defined(_WIN32)
+// io.h used for open(), read(), write() and close()
+#include <fcntl.h>
+#include <io.h>
+#define STDIN_FILENO 0
+#define STDOUT_FILENO 1
+#else
+#define AOC_HAVE_MMAP
+// fcntl.h used for open(), posix_fadvise(), tee() and splice()
+#include <fcntl.h>
+// sys/mman.h used for mmap() and mincore()
+#include <sys/mman.h>
+// sys/stat.h used for fstat()
+#include <sys/stat.h>
+// unistd.h used for read(), write(), close() and sysconf()
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#define AOC_HAVE_DIRECT
+#define AOC_HAVE_SPLICE
+#define AOC_HAVE_EPOLL
+// sys/epoll.h used for epoll_create1(), epoll_ctl() and epoll_wait()
+#include <sys/epoll.h>
+#endif
+
+#include "aoc_runtime.h"
+
+/*
+    Buffers for read() are aligned to this many bytes, and the part that read() fills starts at a multiple
+    of it. That's the alignment that disks (and the kernel's page cache) work in, so reads line up with them.
+    O_DIRECT insists on it: the buffer, the file offset and the length all have to be multiples of the disk's
+    block size, which is 4096 bytes at most on the disks we know of.
+*/
+#define ALIGNMENT 4096
+
+typedef enum AOC_SLOT_STATE
+{
+    SlotFree,  // Not in use. The reading thread may fill it.
+    SlotReady, // Holds a block that no worker has taken yet.
+    SlotBusy,  // A worker is working on its block.
+    SlotDone   // The worker is finished, and the block is waiting to be merged.
+} aoc_slot_state_t;
+
+typedef struct AOC_SLOT
+{
+    aoc_block_t block;
+    aoc_slot_state_t state;
+    unsigned char *buffer; // For read(): 'carryRoom' bytes for the end of the last block, then 'blockSize' to read into.
+    size_t carryRoom;
+    size_t capacity;       // With several inputs: how many bytes 'buffer' has (see gather()).
+    void *map;             // For mmap(): the mapping that 'block' is in, or NULL.
+    size_t mapLength;
+} aoc_slot_t;
+
+// Everything the threads share. Anything that changes is only touched while holding 'lock'.
+typedef struct AOC_SHARED
+{
+    aoc_pipeline_t *pipeline;
+    int fd;                        // The input, or -1 with several.
+    unsigned long long dropFrom;   // With 'dropCache': where the pages we haven't dropped yet may start.
+    aoc_slot_t *slots;             // 'depth' of them. Block N always goes in slot N % depth.
+    mtx_t lock;
+    cnd_t ready;                   // Signalled when there's a new block, or nothing more will come.
+    cnd_t freed;                   // Signalled when a slot becomes free.
+    unsigned long long blocksRead; // How many blocks the reading thread has filled.
+    unsigned long long nextTake;   // The next block for a worker to take.
+    unsigned long long nextMerge;  // The next block to merge.
+    unsigned workersStarted;       // How many workers have started, which gives each one a number.
+    bool finished;                 // No more blocks are coming.
+    unsigned long long windowStart, windowBytes; // For 'progress': when the throughput was last worked out, and the bytes then.
+    bool stopped;                  // 'merge' asked us to stop.
+} aoc_shared_t;
+
+/*
+    How far behind the end of each merged block we ask the kernel to drop pages, with 'dropCache'.
+
+    The page cache keeps files in "folios" of one page or more: up to 2 MiB, for a file read from start to
+    end. The kernel only drops whole folios that nobody has mapped, so a folio that sticks out past the end
+    of a block stays until a later block is merged, and that later block has to cover it too.
+
+    See: https://lwn.net/Articles/893512/ (folios in the page cache)
+*/
+#define DROP_BEHIND (2ull << 20)
+
+/*
+    Let go of whatever a slot's block is in, once the block is merged.
+
+    With 'dropCache', we also tell the kernel that we won't read this part of the file again, so it can
+    throw its copy out of the page cache now, instead of pushing out pages that other programs still want.
+    The mapping has to go first, since mapped pages can't be dropped.
+
+    See: https://man7.org/linux/man-pages/man2/posix_fadvise.2.html
+*/
+static void release(aoc_shared_t *shared, aoc_slot_t *slot, bool merged)
+{
+#if defined(AOC_HAVE_MMAP)
+    if (slot->map != NULL)
+        (void)munmap(slot->map, slot->mapLength);
+    if (merged && shared->pipeline->dropCache) // Errors don't matter: on a pipe, there's no cache to drop.
+    {
+        unsigned long long end = slot->block.offset + slot->block.length;
+        (void)posix_fadvise(shared->fd, (off_t)shared->dropFrom, (off_t)(end - shared->dropFrom), POSIX_FADV_DONTNEED);
+        if (end > DROP_BEHIND && end - DROP_BEHIND > shared->dropFrom)
+            shared->dropFrom = end - DROP_BEHIND;
+    }
+#else
+    (void)shared;
+    (void)merged;
+#endif
+    slot->map = NULL;
+}
+
+/*
+    Show how far we've got in 'progress', after merging a block. Its throughput is worked out over a "window"
+    of a quarter of a second or more, which smooths out the difference between one block and the next.
+*/
+static void publish(aoc_shared_t *shared)
+{
+    aoc_pipeline_t *pipeline = shared->pipeline;
+    aoc_progress_t *progress = pipeline->progress;
+    atomic_store_explicit(&progress->bytes, pipeline->bytes, memory_order_relaxed);
+    atomic_store_explicit(&progress->blocks, pipeline->blocks, memory_order_relaxed);
+    unsigned long long now = aoc_now_ns();
+    if (now - shared->windowStart >= 250000000)
+    {
+        unsigned long long bytes = pipeline->bytes - shared->windowBytes;
+        atomic_store_explicit(&progress->throughput, (unsigned long long)((double)bytes * 1e9 / (double)(now - shared->windowStart)),
+                              memory_order_relaxed);
+        shared->windowStart = now;
+        shared->windowBytes = pipeline->bytes;
+    }
+}
+
+/*
+    A worker takes blocks in order, works on each one, and then merges every finished block that's next in line.
+
+    Merging happens while holding the lock, which is what makes the merges happen one at a time, in order.
+    It should be quick: it just adds up results that the (slow) work already produced.
+
+    See: https://en.cppreference.com/w/c/thread/cnd_wait
+*/
+static int worker(void *argument)
+{
+    aoc_shared_t *shared = argument;
+    aoc_pipeline_t *pipeline = shared->pipeline;
+    (void)mtx_lock(&shared->lock);
+    unsigned number = shared->workersStarted++;
+    const aoc_placement_t *placement = pipeline->placement;
+    if (placement != NULL && placement->count > 0)
+        (void)aoc_pin(&placement->cpus[number % placement->count], 1, NULL);
+    for (;;)
+    {
+        while (!shared->stopped && shared->nextTake == shared->blocksRead && !shared->finished)
+            (void)cnd_wait(&shared->ready, &shared->lock);
+        if (shared->stopped || shared->nextTake == shared->blocksRead) // Stopped, or finished with nothing left.
+            break;
+        aoc_slot_t *slot = &shared->slots[shared->nextTake++ % pipeline->depth];
+        slot->state = SlotBusy;
+        slot->block.worker = number;
+
+        (void)mtx_unlock(&shared->lock);
+        pipeline->work(pipeline->context, &slot->block);
+        (void)mtx_lock(&shared->lock);
+
+        slot->state = SlotDone;
+        while (!shared->stopped && shared->nextMerge < shared->blocksRead)
+        {
+            aoc_slot_t *next = &shared->slots[shared->nextMerge % pipeline->depth];
+            if (next->state != SlotDone)
+                break;
+            if (!pipeline->merge(pipeline->context, &next->block))
+            {
+                shared->stopped = true;
+                (void)cnd_broadcast(&shared->ready);
+                (void)cnd_broadcast(&shared->freed);
+            }
+            pipeline->blocks++;
+            pipeline->bytes += next->block.length;
+            if (pipeline->progress != NULL)
+                publish(shared);
+            release(shared, next, true);
+            next->state = SlotFree;
+            shared->nextMerge++;
+            (void)cnd_signal(&shared->freed);
+        }
+    }
+    (void)mtx_unlock(&shared->lock);
+    return 0;
+}
+
+// What the reading thread knows about the input.
+typedef struct AOC_READER
+{
+    aoc_pipeline_t *pipeline;
+    int fd;
+    size_t source;              // Which input this is, with several (0 otherwise).
+    unsigned long long blocks;  // How many blocks of it have been handed out.
+    unsigned long long offset;  // Where the next block starts.
+    unsigned long long size;    // The file's size, when mapping it.
+    unsigned char *carry;       // For read(): the start of a line that didn't fit in the last block.
+    size_t carryLength, carryCapacity;
+    bool end;                   // Reached the end of the input.
+    bool direct;                // Reading with O_DIRECT, which stops at 'size' (see read_block()).
+    unsigned long long consumed; // How many bytes read() has given us.
+    double tokens;              // For 'rate': how many bytes we may hand out right now.
+    unsigned long long filled;  // For 'rate': when 'tokens' was last topped up, from aoc_now_ns().
+    bool zeroCopy;              // For 'tee': whether tee() and splice() have worked so far (see forward()).
+    bool polled;                // With several inputs: whether epoll tells us when it has something (see await()).
+} aoc_reader_t;
+
+/*
+    With 'tee', every byte of the input goes to standard output as well, unchanged and in order, as it's read.
+
+    Copying them with write() means the kernel copies them into our memory (for read(), or when we touch a
+    mapped page), and then back out again. Linux can do better when standard output is a pipe: splice()
+    moves a file's pages into the pipe, and when the input is a pipe too, tee() duplicates what's waiting in
+    it, without taking it out, so the read() that follows still gets it. Either way, the bytes never come
+    through our memory on their way to the output. Where they can't be used (say, the output is a file,
+    which splice() only takes from a pipe), they fail straight away, and we write() from then on.
+
+    See: https://man7.org/linux/man-pages/man2/tee.2.html
+    See: https://man7.org/linux/man-pages/man2/splice.2.html
+*/
+
+// Write all 'length' bytes at 'data' to standard output.
+static const char *write_out(const unsigned char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t want = length < 1u << 30 ? length : 1u << 30; // Windows' write() takes an 'unsigned'.
+        long n = (long)write(STDOUT_FILENO, data, (unsigned)want);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return "Unable to write output";
+        data += n;
+        length -= (size_t)n;
+    }
+    return NULL;
+}
+
+// With 'tee': copy a mapped block, which starts at 'offset' in the file, to standard output.
+static const char *forward(aoc_reader_t *reader, const unsigned char *data, size_t length, unsigned long long offset)
+{
+#if defined(AOC_HAVE_SPLICE)
+    loff_t from = (loff_t)offset;
+    while (reader->zeroCopy && length > 0)
+    {
+        long n = (long)splice(reader->fd, &from, STDOUT_FILENO, NULL, length, SPLICE_F_MORE);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) // Standard output isn't a pipe (or something else went wrong, which write() will find too).
+        {
+            reader->zeroCopy = false;
+            break;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+#else
+    (void)reader;
+    (void)offset;
+#endif
+    return write_out(data, length);
+}
+
+/*
+    read() up to 'want' bytes into 'buffer', and store how many came in '*got' (0 at the end of the input).
+    With 'tee', they go to standard output too.
+*/
+static const char *read_input(aoc_reader_t *reader, unsigned char *buffer, size_t want, size_t *got)
+{
+    if (want > 1u << 30) // Windows' read() takes an 'unsigned'.
+        want = 1u << 30;
+#if defined(AOC_HAVE_SPLICE)
+    while (reader->pipeline->tee && reader->zeroCopy)
+    {
+        long n = (long)tee(reader->fd, STDOUT_FILENO, want, 0); // Waits for something to come, like read().
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) // One of them isn't a pipe.
+        {
+            reader->zeroCopy = false;
+            break;
+        }
+        for (*got = 0; *got < (size_t)n;) // They're waiting in the pipe, so read() gets them all, soon enough.
+        {
+            long m = (long)read(reader->fd, buffer + *got, (unsigned)((size_t)n - *got));
+            if (m < 0 && errno == EINTR)
+                continue;
+            if (m <= 0)
+                return "Unable to read input";
+            *got += (size_t)m;
+        }
+        return NULL;
+    }
+#endif
+    for (;;)
+    {
+        long n = (long)read(reader->fd, buffer, (unsigned)want);
+        if (n < 0 && errno == EINTR) // Interrupted by a signal before reading anything: just try again.
+            continue;
+        if (n < 0)
+            return "Unable to read input";
+        *got = (size_t)n;
+        return reader->pipeline->tee ? write_out(buffer, *got) : NULL;
+    }
+}
+
+/*
+    Wait until the block of 'length' bytes we just read fits in 'rate' bytes per second, before handing it out.
+
+    This is a "token bucket". Tokens (bytes we may read) drip into the bucket at 'rate' per second, up to
+    a block's worth, and each block takes out its length. When there aren't enough, we sleep until there
+    would be. On average we can't go faster than 'rate', but after a pause, one block can go straight away.
+
+    See: https://en.wikipedia.org/wiki/Token_bucket
+*/
+static void throttle(aoc_reader_t *reader, size_t length)
+{
+    aoc_pipeline_t *pipeline = reader->pipeline;
+    if (pipeline->rate == 0)
+        return;
+    unsigned long long now = aoc_now_ns();
+    reader->tokens += (double)(now - reader->filled) * 1e-9 * (double)pipeline->rate;
+    if (reader->tokens > (double)pipeline->blockSize)
+        reader->tokens = (double)pipeline->blockSize;
+    reader->filled = now;
+    reader->tokens -= (double)length;
+    if (reader->tokens >= 0)
+        return;
+
+    double seconds = -reader->tokens / (double)pipeline->rate;
+    struct timespec wait = {.tv_sec = (time_t)seconds, .tv_nsec = (long)((seconds - (double)(time_t)seconds) * 1e9)};
+    while (thrd_sleep(&wait, &wait) == -1) // -1: woken early by a signal, and 'wait' is what's left.
+        ;
+    reader->filled = aoc_now_ns();
+    reader->tokens = 0; // The tokens that dripped in while we slept paid for this block.
+    pipeline->waited += reader->filled - now;
+}
+
+#if defined(AOC_HAVE_MMAP)
+/*
+    Fill 'slot' with the next block of a regular file, by mapping a window of it.
+
+    mmap() can only start at a multiple of the page size, so we map from the page the block starts in.
+    If the window doesn't contain a whole line, we try again with a window twice as big.
+*/
+static const char *map_block(aoc_reader_t *reader, aoc_slot_t *slot, bool *filled)
+{
+    aoc_pipeline_t *pipeline = reader->pipeline;
+    const unsigned long long page = (unsigned long long)sysconf(_SC_PAGESIZE);
+    unsigned long long left = reader->size - reader->offset;
+    size_t window = left < pipeline->blockSize ? (size_t)left : pipeline->blockSize;
+    *filled = false;
+    if (left == 0)
+    {
+        reader->end = true;
+        return NULL;
+    }
+    for (;;)
+    {
+        unsigned long long start = reader->offset - reader->offset % page;
+        size_t skip = (size_t)(reader->offset - start);
+        void *map = mmap(NULL, skip + window, PROT_READ, MAP_PRIVATE, reader->fd, (off_t)start);
+        if (map == MAP_FAILED)
+            return "Unable to map input";
+        (void)posix_madvise(map, skip + window, POSIX_MADV_SEQUENTIAL);
+        const unsigned char *data = (const unsigned char *)map + skip;
+        size_t length = window == left ? window : pipeline->split(pipeline->context, reader->source, data, window);
+        if (length == 0) // Not even one whole line: look further.
+        {
+            (void)munmap(map, skip + window);
+            window = left / 2 < window ? (size_t)left : window * 2;
+            continue;
+        }
+        slot->map = map;
+        slot->mapLength = skip + window;
+        slot->block.data = data;
+        slot->block.length = length;
+        *filled = true;
+        const char *error = pipeline->tee ? forward(reader, data, length, reader->offset) : NULL;
+        reader->offset += length;
+        return error;
+    }
+}
+#endif
+
+/*
+    Fill 'slot' with the next block of a pipe (or anything else we can't map), with read().
+
+    The start of a line that didn't fit in the last block is copied in first, just in front of the bytes
+    we read, so the block is one piece of memory. If it's longer than the room we left for it, the slot's
+    buffer grows.
+*/
+static const char *read_block(aoc_reader_t *reader, aoc_slot_t *slot, bool *filled)
+{
+    aoc_pipeline_t *pipeline = reader->pipeline;
+    *filled = false;
+    for (;;)
+    {
+        if (slot->buffer == NULL || slot->carryRoom < reader->carryLength)
+        {
+            size_t room = (reader->carryLength + ALIGNMENT) / ALIGNMENT * ALIGNMENT; // Round up, with room to spare.
+            if (room > (size_t)-1 - pipeline->blockSize)
+                return "Out of memory";
+            // aligned_alloc() needs a size that's a multiple of the alignment. See: https://en.cppreference.com/w/c/memory/aligned_alloc
+            size_t size = (room + pipeline->blockSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            unsigned char *buffer = aligned_alloc(ALIGNMENT, size);
+            if (buffer == NULL)
+                return "Out of memory";
+            free(slot->buffer);
+            slot->buffer = buffer;
+            slot->carryRoom = room;
+        }
+        unsigned char *start = slot->buffer + slot->carryRoom - reader->carryLength;
+        if (reader->carryLength > 0)
+            memcpy(start, reader->carry, reader->carryLength);
+
+        /*
+            Fill the buffer: a pipe gives us whatever has been written so far, so one read() may not be enough.
+            With O_DIRECT, the last read() of the file is a short one, after which the offset isn't a multiple of
+            ALIGNMENT anymore, and reading again would fail. So we stop at the file's size instead.
+        */
+        size_t got = 0;
+        while (got < pipeline->blockSize)
+        {
+            if (reader->direct && reader->consumed == reader->size)
+            {
+                reader->end = true;
+                break;
+            }
+            size_t n;
+            const char *error = read_input(reader, slot->buffer + slot->carryRoom + got, pipeline->blockSize - got, &n);
+            if (error != NULL)
+                return error;
+            if (n == 0)
+            {
+                reader->end = true;
+                break;
+            }
+            got += n;
+            reader->consumed += n;
+        }
+
+        size_t length = reader->carryLength + got;
+        size_t cut = reader->end ? length : pipeline->split(pipeline->context, reader->source, start, length);
+        size_t left = length - cut;
+        if (left > reader->carryCapacity) // Keep what's left over (or everything, if there wasn't a whole line).
+        {
+            unsigned char *bigger = realloc(reader->carry, left);
+            if (bigger == NULL)
+                return "Out of memory";
+            reader->carry = bigger;
+            reader->carryCapacity = left;
+        }
+        memcpy(reader->carry, start + cut, left);
+        reader->carryLength = left;
+        if (cut > 0 || reader->end)
+        {
+            slot->block.data = start;
+            slot->block.length = cut;
+            reader->offset += cut;
+            *filled = cut > 0;
+            return NULL;
+        }
+    }
+}
+
+/*
+    Check whether the 'deadline' has passed. The reading thread checks before each block, so the scan itself
+    never looks at the clock, and once it has passed, we just stop handing out blocks. Whatever is ahead of
+    the last one handed out (including a read() that's waiting for a pipe) still has to finish first, so
+    we can overshoot by up to a few blocks' worth of scanning.
+*/
+static bool expired(aoc_pipeline_t *pipeline)
+{
+    if (pipeline->deadline != 0 && !pipeline->expired && aoc_now_ns() >= pipeline->deadline)
+        pipeline->expired = true;
+    return pipeline->expired;
+}
+
+/*
+    Several inputs at once, for aoc_pipeline_fan_in(): say, a FIFO for each of several programs that write
+    lines as they go. We can't just read one after another, because a program whose FIFO we aren't reading
+    has to wait once the FIFO is full (64 KiB, on Linux), and the others may be slow to finish. So we read
+    whichever have something to read, which epoll tells us, and cut each input into blocks of its own.
+
+    Each input has a buffer of its own (its 'carry'), where what we've read of it waits until there's a
+    block's worth, or the input ends. So an input's lines only ever share a block with its own lines, and a
+    line that arrives in pieces is put back together before anyone scans it.
+
+    See: https://man7.org/linux/man-pages/man7/epoll.7.html
+    See: https://man7.org/linux/man-pages/man7/fifo.7.html
+*/
+
+// Where the reading thread gets blocks from: one input, or several (with aoc_pipeline_fan_in()).
+typedef struct AOC_FEED
+{
+    aoc_reader_t *readers; // 'count' of them, one per input.
+    size_t count;
+    size_t open;           // How many inputs still have blocks to come.
+    bool fanIn;            // Whether this is aoc_pipeline_fan_in(), which gather()s blocks from every input.
+    size_t next;           // Which input to look at first for the next block, so they take turns.
+    int epoll;             // The epoll instance that waits for the inputs, or -1.
+} aoc_feed_t;
+
+/*
+    read() what's waiting in one of several inputs onto the end of its buffer. The buffer grows to make room
+    for a block's worth, and more if a line is longer than that.
+*/
+static const char *take(aoc_feed_t *feed, aoc_reader_t *reader)
+{
+    aoc_pipeline_t *pipeline = reader->pipeline;
+    if (reader->carryCapacity - reader->carryLength < pipeline->blockSize)
+    {
+        if (reader->carryLength > (size_t)-1 - pipeline->blockSize)
+            return "Out of memory";
+        size_t capacity = reader->carryLength + pipeline->blockSize;
+        unsigned char *bigger = realloc(reader->carry, capacity);
+        if (bigger == NULL)
+            return "Out of memory";
+        reader->carry = bigger;
+        reader->carryCapacity = capacity;
+    }
+    for (;;)
+    {
+        size_t want = pipeline->blockSize < 1u << 30 ? pipeline->blockSize : 1u << 30; // See read_input().
+        long n = (long)read(reader->fd, reader->carry + reader->carryLength, (unsigned)want);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) // Nothing after all (epoll can be wrong about that).
+            return NULL;
+        if (n < 0)
+        {
+            pipeline->failed = reader->source;
+            return "Unable to read input";
+        }
+        if (n == 0) // Closing it takes it out of epoll, too.
+        {
+            (void)close(reader->fd);
+            reader->fd = -1;
+            reader->end = true;
+            if (reader->carryLength == 0)
+                feed->open--;
+        }
+        reader->carryLength += (size_t)n;
+        reader->consumed += (size_t)n;
+        return NULL;
+    }
+}
+
+/*
+    Wait until some of the inputs have something to read, and read it. Inputs epoll can't wait for (regular
+    files, or every input, without epoll) always have something, so we read one of those each time too, taking
+    turns, and only check on the others without waiting.
+*/
+static const char *await(aoc_feed_t *feed)
+{
+    aoc_reader_t *plain = NULL; // The next input that we read without waiting for it.
+    for (size_t k = 0; plain == NULL && k < feed->count; k++)
+    {
+        aoc_reader_t *reader = &feed->readers[(feed->next + k) % feed->count];
+        if (!reader->end && !reader->polled)
+            plain = reader;
+    }
+#if defined(AOC_HAVE_EPOLL)
+    struct epoll_event events[64];
+    int timeout = plain != NULL ? 0 : -1; // -1: as long as it takes.
+    aoc_pipeline_t *pipeline = feed->readers[0].pipeline;
+    if (timeout < 0 && pipeline->deadline != 0) // Or until the deadline, in milliseconds, rounded up.
+    {
+        unsigned long long now = aoc_now_ns();
+        unsigned long long left = pipeline->deadline > now ? (pipeline->deadline - now + 999999) / 1000000 : 0;
+        timeout = left < 1u << 30 ? (int)left : 1 << 30;
+    }
+    int n = epoll_wait(feed->epoll, events, 64, timeout);
+    if (n < 0 && errno != EINTR)
+        return "Unable to wait for input";
+    for (int i = 0; i < n; i++)
+    {
+        const char *error = take(feed, &feed->readers[events[i].data.u64]);
+        if (error != NULL)
+            return error;
+    }
+#endif
+    return plain != NULL ? take(feed, plain) : NULL;
+}
+
+/*
+    Fill 'slot' with the next block from one of several inputs, reading them until one has a block ready: a
+    block's worth of whole lines, or whatever is left once it ends. The inputs take turns, so one that's always
+    ready doesn't hold up the others.
+
+    The block's bytes are already in memory, in its input's buffer. Rather than copy them, that buffer becomes
+    the slot's, and the input gets the slot's old buffer, for the start of a line that didn't fit.
+*/
+static const char *gather(aoc_feed_t *feed, aoc_slot_t *slot, bool *filled)
+{
+    *filled = false;
+    while (feed->open > 0 && !expired(feed->readers[0].pipeline))
+    {
+        for (size_t k = 0; k < feed->count; k++)
+        {
+            size_t source = (feed->next + k) % feed->count;
+            aoc_reader_t *reader = &feed->readers[source];
+            aoc_pipeline_t *pipeline = reader->pipeline;
+            size_t cut = 0;
+            if (reader->end)
+                cut = reader->carryLength;
+            else if (reader->carryLength >= pipeline->blockSize)
+                cut = pipeline->split(pipeline->context, source, reader->carry, reader->carryLength);
+            if (cut == 0)
+                continue;
+
+            size_t left = reader->carryLength - cut;
+            if (slot->capacity < left)
+            {
+                unsigned char *bigger = realloc(slot->buffer, left);
+                if (bigger == NULL)
+                    return "Out of memory";
+                slot->buffer = bigger;
+                slot->capacity = left;
+            }
+            memcpy(slot->buffer, reader->carry + cut, left);
+            unsigned char *buffer = reader->carry;
+            size_t capacity = reader->carryCapacity;
+            reader->carry = slot->buffer;
+            reader->carryCapacity = slot->capacity;
+            reader->carryLength = left;
+            slot->buffer = buffer;
+            slot->capacity = capacity;
+
+            slot->block.data = buffer;
+            slot->block.length = cut;
+            slot->block.offset = reader->offset;
+            slot->block.source = source;
+            slot->block.index = reader->blocks++;
+            reader->offset += cut;
+            if (reader->end) // That was the last of it.
+                feed->open--;
+            feed->next = (source + 1) % feed->count;
+            *filled = true;
+            return NULL;
+        }
+        const char *error = await(feed);
+        if (error != NULL)
+            return error;
+    }
+    return NULL;
+}
+
+#if defined(AOC_HAVE_DIRECT)
+// With AocIoAuto, files smaller than this are always mapped: reading them through the cache can't push much else out.
+#define DIRECT_MIN_SIZE (64ull << 20)
+// How many of a file's pages to check, to see how much of it is cached.
+#define PROBE_PAGES 64
+
+/*
+    Check how much of a file is in the page cache, by asking about PROBE_PAGES pages spread evenly through it.
+
+    mincore() says which pages of a mapping are in memory. Mapping the whole file is cheap, because nothing
+    is read until it's touched, and mincore() doesn't touch anything. A sample is enough to tell "hot" from
+    "cold", and asking about every page of a huge file would take a while (and a byte per page for the answer).
+
+    See: https://man7.org/linux/man-pages/man2/mincore.2.html
+*/
+static void probe(aoc_pipeline_t *pipeline, int fd, unsigned long long size)
+{
+    if (size == 0 || size > (size_t)-1)
+        return;
+    const unsigned long long page = (unsigned long long)sysconf(_SC_PAGESIZE);
+    void *map = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+        return;
+    unsigned long long pages = (size + page - 1) / page;
+    unsigned samples = pages < PROBE_PAGES ? (unsigned)pages : PROBE_PAGES;
+    for (unsigned i = 0; i < samples; i++)
+    {
+        unsigned char cached;
+        if (mincore((unsigned char *)map + pages * i / samples * page, 1, &cached) == 0)
+        {
+            pipeline->sampled++;
+            pipeline->resident += cached & 1; // The other bits are reserved.
+        }
+    }
+    (void)munmap(map, (size_t)size);
+}
+#endif
+
+void aoc_pipeline_size(aoc_pipeline_t *pipeline, const aoc_limits_t *limits)
+{
+    *pipeline = (aoc_pipeline_t){0};
+    pipeline->workers = limits->cpus;
+    pipeline->depth = 2 * limits->cpus;
+    pipeline->io = AocIoAuto;
+
+    /*
+        Blocks of a few megabytes are big enough that handing one over costs nothing in comparison, and small
+        enough that the workers share the input evenly. They also have to fit in our memory limit: all the blocks
+        together should take at most an eighth of it, leaving the rest for everything else. Mapped files count
+        too, because cgroups charge the page cache to whoever read the file.
+    */
+    size_t blockSize = 4 << 20;
+    if (limits->memory != 0 && limits->memory / 8 / pipeline->depth < blockSize)
+        blockSize = (size_t)(limits->memory / 8 / pipeline->depth);
+    if (blockSize < 64 << 10)
+        blockSize = 64 << 10;
+    pipeline->blockSize = blockSize / ALIGNMENT * ALIGNMENT;
+}
+
+/*
+    Wait for 'slot' to be free (with the lock held), or for the 'deadline' to pass. cnd_timedwait() wants a
+    time on the calendar (TIME_UTC), rather than aoc_now_ns()'s clock, so we work out how far away it is.
+
+    See: https://en.cppreference.com/w/c/thread/cnd_timedwait
+*/
+static void wait_free(aoc_shared_t *shared, aoc_slot_t *slot)
+{
+    aoc_pipeline_t *pipeline = shared->pipeline;
+    while (!shared->stopped && slot->state != SlotFree && !expired(pipeline))
+    {
+        if (pipeline->deadline == 0)
+        {
+            (void)cnd_wait(&shared->freed, &shared->lock);
+            continue;
+        }
+        unsigned long long left = pipeline->deadline - aoc_now_ns(); // expired() just said it's still ahead.
+        struct timespec until;
+        (void)timespec_get(&until, TIME_UTC);
+        left += (unsigned long long)until.tv_nsec;
+        until.tv_sec += (time_t)(left / 1000000000);
+        until.tv_nsec = (long)(left % 1000000000);
+        (void)cnd_timedwait(&shared->freed, &shared->lock, &until);
+    }
+}
+
+// Fill in the defaults for any settings that weren't set, and zero what aoc_pipeline_run() fills in.
+static void prepare(aoc_pipeline_t *pipeline)
+{
+    if (pipeline->workers == 0)
+        pipeline->workers = 1;
+    if (pipeline->depth < 2)
+        pipeline->depth = 2;
+    if (pipeline->blockSize == 0)
+        pipeline->blockSize = ALIGNMENT;
+    pipeline->kind = AocInputBuffered;
+    pipeline->blocks = pipeline->bytes = pipeline->waited = 0;
+    pipeline->sampled = pipeline->resident = 0;
+    pipeline->failed = 0;
+    pipeline->expired = false;
+}
+
+/*
+    Start the workers, fill slots with blocks from 'feed' until it runs dry or a merge says stop, and wait for
+    the workers to finish. 'fd' is the input (or -1 with several), and 'size' its size, if we know it.
+*/
+static const char *run(aoc_pipeline_t *pipeline, aoc_feed_t *feed, int fd, unsigned long long size)
+{
+    aoc_shared_t shared = {.pipeline = pipeline, .fd = fd, .windowStart = aoc_now_ns()};
+    if (pipeline->progress != NULL)
+        aoc_progress_start(pipeline->progress, size);
+    shared.slots = calloc(pipeline->depth, sizeof *shared.slots);
+    unsigned char *results = calloc(pipeline->depth, pipeline->resultSize > 0 ? pipeline->resultSize : 1);
+    thrd_t *threads = calloc(pipeline->workers, sizeof *threads);
+    const char *error = NULL;
+    bool synchronized = false; // Whether the mutex and condition variables were made, and need destroying.
+    if (shared.slots == NULL || results == NULL || threads == NULL)
+        error = "Out of memory";
+    else if (mtx_init(&shared.lock, mtx_plain) != thrd_success || cnd_init(&shared.ready) != thrd_success ||
+             cnd_init(&shared.freed) != thrd_success)
+        error = "Unable to start threads";
+    else
+        synchronized = true;
+    unsigned started = 0;
+    for (unsigned i = 0; error == NULL && i < pipeline->depth; i++)
+        shared.slots[i].block.result = results + i * pipeline->resultSize;
+    while (error == NULL && started < pipeline->workers && thrd_create(&threads[started], worker, &shared) == thrd_success)
+        started++;
+    if (error == NULL && started == 0)
+        error = "Unable to start threads";
+
+    /*
+        This thread is the reader: fill each free slot in turn, until the input ends or a merge says stop.
+        It runs next to the workers, where the blocks it reads are still in the cache they share.
+    */
+    aoc_placement_t callerCpus; // Where the caller could run before, to put it back afterwards.
+    bool pinned = false;
+    if (error == NULL && pipeline->placement != NULL && pipeline->placement->count > 0)
+        pinned = aoc_pin(pipeline->placement->cpus, pipeline->placement->shared, &callerCpus);
+    while (error == NULL && feed->open > 0)
+    {
+        aoc_slot_t *slot = &shared.slots[shared.blocksRead % pipeline->depth]; // Only this thread changes blocksRead.
+        (void)mtx_lock(&shared.lock);
+        wait_free(&shared, slot);
+        bool stopped = shared.stopped || expired(pipeline);
+        (void)mtx_unlock(&shared.lock);
+        if (stopped)
+            break;
+
+        bool filled = false;
+        if (feed->fanIn)
+            error = gather(feed, slot, &filled);
+        else
+        {
+            aoc_reader_t *reader = feed->readers;
+            slot->block.offset = reader->offset;
+            slot->block.source = 0;
+#if defined(AOC_HAVE_MMAP)
+            if (pipeline->kind == AocInputMapped)
+                error = map_block(reader, slot, &filled);
+            else
+#endif
+                error = read_block(reader, slot, &filled);
+            if (reader->end)
+                feed->open = 0;
+            if (filled)
+                slot->block.index = reader->blocks++;
+        }
+        if (!filled)
+            continue;
+        throttle(&feed->readers[slot->block.source], slot->block.length);
+
+        (void)mtx_lock(&shared.lock);
+        shared.blocksRead++;
+        slot->state = SlotReady;
+        (void)cnd_signal(&shared.ready);
+        (void)mtx_unlock(&shared.lock);
+    }
+
+    // No more blocks: wake every worker, so they finish what's left and see that there's nothing more.
+    if (started > 0)
+    {
+        (void)mtx_lock(&shared.lock);
+        shared.finished = true;
+        if (error != NULL)
+            shared.stopped = true;
+        (void)cnd_broadcast(&shared.ready);
+        (void)mtx_unlock(&shared.lock);
+    }
+    for (unsigned i = 0; i < started; i++)
+        (void)thrd_join(threads[i], NULL);
+    if (pinned)
+        (void)aoc_pin(callerCpus.cpus, callerCpus.count, NULL);
+    if (pipeline->progress != NULL)
+        atomic_store_explicit(&pipeline->progress->finished, true, memory_order_relaxed);
+
+    for (unsigned i = 0; shared.slots != NULL && i < pipeline->depth; i++)
+    {
+        release(&shared, &shared.slots[i], false); // Blocks that were never merged, because we stopped early.
+        free(shared.slots[i].buffer);
+    }
+#if defined(AOC_HAVE_MMAP)
+    if (pipeline->dropCache && fd >= 0) // Nothing is mapped now, so whatever is left behind can go (0 means "to the end").
+        (void)posix_fadvise(fd, (off_t)shared.dropFrom, 0, POSIX_FADV_DONTNEED);
+#endif
+    if (synchronized)
+    {
+        mtx_destroy(&shared.lock);
+        cnd_destroy(&shared.ready);
+        cnd_destroy(&shared.freed);
+    }
+    free(shared.slots);
+    free(results);
+    free(threads);
+    return error;
+}
+
+const char *aoc_pipeline_run(aoc_pipeline_t *pipeline, const char *path)
+{
+    prepare(pipeline);
+    aoc_reader_t reader = {.pipeline = pipeline, .fd = STDIN_FILENO, .tokens = (double)pipeline->blockSize,
+                           .filled = aoc_now_ns(), .zeroCopy = true};
+    if (path != NULL && (reader.fd = open(path, O_RDONLY)) < 0)
+        return "Unable to open file";
+#if defined(_WIN32)
+    if (path == NULL)
+        (void)_setmode(STDIN_FILENO, _O_BINARY); // See aoc_input_load().
+    if (pipeline->tee)
+        (void)_setmode(STDOUT_FILENO, _O_BINARY); // Or "\n" would come out as "\r\n".
+#endif
+#if defined(AOC_HAVE_MMAP)
+    struct stat info;
+    if (pipeline->io != AocIoRead && fstat(reader.fd, &info) == 0 && S_ISREG(info.st_mode))
+    {
+        reader.size = (unsigned long long)info.st_size;
+        aoc_io_t io = pipeline->io;
+#if defined(AOC_HAVE_DIRECT)
+        if (io == AocIoAuto) // Cold (less than half cached) and big: read it directly.
+        {
+            probe(pipeline, reader.fd, reader.size);
+            io = pipeline->resident * 2 < pipeline->sampled && reader.size >= DIRECT_MIN_SIZE ? AocIoDirect : AocIoMap;
+        }
+
+        /*
+            F_SETFL can switch O_DIRECT on for a file that's already open. Some file systems can't do direct I/O,
+            and say so here, so we read through the cache after all. We leave standard input alone: its open
+            file is shared with whoever started us.
+        */
+        if (io == AocIoDirect && path != NULL && fcntl(reader.fd, F_SETFL, fcntl(reader.fd, F_GETFL) | O_DIRECT) == 0)
+        {
+            pipeline->kind = AocInputDirect;
+            pipeline->blockSize = (pipeline->blockSize + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            reader.direct = true;
+        }
+#endif
+        if (io == AocIoMap || io == AocIoAuto) // Still AocIoAuto without mincore(), so do what's usually fastest.
+            pipeline->kind = AocInputMapped;
+    }
+#endif
+
+    aoc_feed_t feed = {.readers = &reader, .count = 1, .open = 1, .epoll = -1};
+    const char *error = run(pipeline, &feed, reader.fd, reader.size);
+#if defined(AOC_HAVE_SPLICE)
+    pipeline->zeroCopy = pipeline->tee && reader.zeroCopy;
+#endif
+    free(reader.carry);
+    if (path != NULL)
+        (void)close(reader.fd);
+    return error;
+}
+
+const char *aoc_pipeline_fan_in(aoc_pipeline_t *pipeline, const char *const *paths, size_t count)
+{
+    prepare(pipeline);
+    aoc_feed_t feed = {.readers = calloc(count > 0 ? count : 1, sizeof *feed.readers), .count = count, .open = count,
+                       .fanIn = true, .epoll = -1};
+    if (feed.readers == NULL)
+        return "Out of memory";
+    const char *error = NULL;
+#if defined(AOC_HAVE_EPOLL)
+    if ((feed.epoll = epoll_create1(EPOLL_CLOEXEC)) < 0)
+        error = "Unable to wait for input";
+#endif
+    for (size_t i = 0; i < count; i++)
+        feed.readers[i] = (aoc_reader_t){.pipeline = pipeline, .fd = -1, .source = i,
+                                         .tokens = (double)pipeline->blockSize, .filled = aoc_now_ns()};
+
+    /*
+        Opening a FIFO for reading usually waits until something opens it for writing. O_NONBLOCK doesn't wait,
+        so we can open them all, and let epoll tell us when each producer turns up. Without epoll, we open and
+        read each one the ordinary way, and wait for them one after another.
+    */
+    for (size_t i = 0; error == NULL && i < count; i++)
+    {
+        aoc_reader_t *reader = &feed.readers[i];
+#if defined(AOC_HAVE_EPOLL)
+        reader->fd = open(paths[i], O_RDONLY | O_NONBLOCK);
+#else
+        reader->fd = open(paths[i], O_RDONLY);
+#endif
+        if (reader->fd < 0)
+        {
+            pipeline->failed = i;
+            error = "Unable to open file";
+            break;
+        }
+#if defined(_WIN32)
+        (void)_setmode(reader->fd, _O_BINARY);
+#endif
+#if defined(AOC_HAVE_EPOLL)
+        // epoll refuses regular files (with EPERM), which always have something to read. So we just read them.
+        struct epoll_event event = {.events = EPOLLIN, .data.u64 = i};
+        reader->polled = epoll_ctl(feed.epoll, EPOLL_CTL_ADD, reader->fd, &event) == 0;
+#endif
+    }
+
+    if (error == NULL)
+        error = run(pipeline, &feed, -1, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (feed.readers[i].fd >= 0)
+            (void)close(feed.readers[i].fd);
+        free(feed.readers[i].carry);
+    }
+#if defined(AOC_HAVE_EPOLL)
+    if (feed.epoll >= 0)
+        (void)close(feed.epoll);
+#endif
+    free(feed.readers);
+    return error;
+}
@@ -0,0 +1,66 @@
+// This file runs tasks on several threads at once, for aoc_parallel_for() in aoc_runtime.h.
+
+// stdatomic.h used for the shared task counter
+#include <stdatomic.h>
+// stdlib.h used for memory allocation
+#include <stdlib.h>
+// threads.h used for starting and joining threads
+#include <threads.h>
+
+#include "aoc_runtime.h"
+
+// Everything the threads share. 'next' is the only thing that changes, and it's atomic.
+typedef struct AOC_JOB
+{
+    aoc_task_t *task;
+    void *context;
+    size_t count;
+    atomic_size_t next; // The next task nobody has taken yet.
+} aoc_job_t;
+
+/*
+    Each thread takes the next task number, runs it, and repeats until there are none left.
+
+    atomic_fetch_add() adds 1 and returns the old value as one indivisible step, so two threads can
+    never take the same number. "Relaxed" ordering is enough: the number itself is all we share, and
+    thrd_join() makes the tasks' results visible to the caller afterwards.
+
+    Taking one task at a time (rather than splitting the tasks into equal shares up front) keeps every
+    thread busy when some tasks take much longer than others, like a hard puzzle next to an easy one.
+
+    See: https://en.cppreference.com/w/c/atomic/atomic_fetch_add
+    See: https://en.wikipedia.org/wiki/Work_stealing (a fancier way to balance the load)
+*/
+static int work(void *argument)
+{
+    aoc_job_t *job = argument;
+    size_t index;
+    while ((index = atomic_fetch_add_explicit(&job->next, 1, memory_order_relaxed)) < job->count)
+        job->task(job->context, index);
+    return 0;
+}
+
+unsigned aoc_parallel_for(size_t count, unsigned threads, aoc_task_t *task, void *context)
+{
+    aoc_job_t job = {.task = task, .context = context, .count = count};
+    atomic_init(&job.next, 0);
+    if (threads == 0)
+        threads = aoc_cpu_count();
+    if (threads > count) // No point starting threads with nothing to do.
+        threads = count > 0 ? (unsigned)count : 1;
+
+    /*
+        The calling thread is one of the workers, so we start one fewer new thread than asked for.
+        If a thread can't be started, the others just do its share: the work still gets done.
+    */
+    thrd_t *helpers = threads > 1 ? malloc((threads - 1) * sizeof *helpers) : NULL;
+    unsigned started = 0;
+    if (helpers != NULL)
+        while (started < threads - 1 && thrd_create(&helpers[started], work, &job) == thrd_success)
+            started++;
+    (void)work(&job);
+    for (unsigned i = 0; i < started; i++)
+        (void)thrd_join(helpers[i], NULL);
+    free(helpers);
+    return started + 1;
+}
@@ -0,0 +1,239 @@
+// This file shares a long run's progress with other programs, for aoc_progress_share() and friends in aoc_runtime.h.
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // For shm_open(), sigaction() and friends. See input.c.
+#endif
+
+// stdio.h used for snprintf() (but not in the signal handler: see aoc_progress_write())
+#include <stdio.h>
+// time.h used for nanosleep()
+#include <time.h>
+
+#if !defined(_WIN32)
+#define AOC_HAVE_SHM
+// errno.h used for errno
+#include <errno.h>
+// fcntl.h used for the O_ flags of shm_open()
+#include <fcntl.h>
+// signal.h used for sigaction() and kill()
+#include <signal.h>
+// sys/mman.h used for shm_open() and mmap()
+#include <sys/mman.h>
+// unistd.h used for ftruncate(), getpid() and write()
+#include <unistd.h>
+#else
+// io.h used for _write()
+#include <io.h>
+#endif
+
+#include "aoc_runtime.h"
+
+// The first 8 bytes of a progress page, so a watcher knows it's looking at one: "AOCprog1" read as a number.
+#define MAGIC 0x31676f7270434f41ull
+
+#if defined(AOC_HAVE_SHM)
+// The page that SIGUSR1 prints. A signal handler can only see global variables.
+static const aoc_progress_t *volatile SignalProgress;
+
+/*
+    A shared memory object's name starts with a '/', and shows up as a file in /dev/shm on Linux.
+    Each process has its own, named after its process ID, which is all --watch needs to find it.
+*/
+static void page_name(char *name, size_t size, long pid)
+{
+    (void)snprintf(name, size, "/aoc-progress-%ld", pid);
+}
+#endif
+
+const char *aoc_progress_share(aoc_progress_t **progress)
+{
+#if defined(AOC_HAVE_SHM)
+    /*
+        shm_open() makes a "file" that lives in memory. Each program that maps it sees the same memory,
+        so the numbers we store are there for any other program to read, as soon as we store them.
+
+        See: https://man7.org/linux/man-pages/man7/shm_overview.7.html
+    */
+    char name[64];
+    page_name(name, sizeof name, (long)getpid());
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600); // 0600: only our own user may read it.
+    if (fd < 0 && errno == EEXIST) // Left behind by an earlier process with the same ID, that crashed.
+    {
+        (void)shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0)
+        return "Unable to create progress page";
+    void *page = MAP_FAILED;
+    if (ftruncate(fd, sizeof(aoc_progress_t)) == 0)
+        page = mmap(NULL, sizeof(aoc_progress_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd); // The mapping keeps it open.
+    if (page == MAP_FAILED)
+    {
+        (void)shm_unlink(name);
+        return "Unable to map progress page";
+    }
+    *progress = page; // ftruncate() filled it with zeros, which is a fine start.
+    (*progress)->magic = MAGIC;
+    return NULL;
+#else
+    (void)progress;
+    return "Progress pages aren't supported on this system";
+#endif
+}
+
+void aoc_progress_unshare(aoc_progress_t *progress)
+{
+#if defined(AOC_HAVE_SHM)
+    if (SignalProgress == progress) // SIGUSR1 can't print a page that's gone. SIG_IGN: ignore the signal.
+        (void)signal(SIGUSR1, SIG_IGN);
+    char name[64];
+    page_name(name, sizeof name, (long)getpid());
+    (void)shm_unlink(name);
+    (void)munmap(progress, sizeof *progress);
+#else
+    (void)progress;
+#endif
+}
+
+void aoc_progress_start(aoc_progress_t *progress, unsigned long long size)
+{
+    progress->magic = MAGIC;
+    atomic_store_explicit(&progress->size, size, memory_order_relaxed);
+    atomic_store_explicit(&progress->started, aoc_now_ns(), memory_order_relaxed);
+}
+
+/*
+    Append 'value' to 'line' as decimal digits, at 'length'. Returns the new length.
+    snprintf() isn't safe in a signal handler (it may lock, or allocate memory), but this is.
+*/
+static size_t append_number(char *line, size_t length, unsigned long long value)
+{
+    char digits[20];
+    size_t count = 0;
+    do
+        digits[count++] = (char)('0' + value % 10);
+    while ((value /= 10) != 0);
+    while (count > 0)
+        line[length++] = digits[--count];
+    return length;
+}
+
+static size_t append_text(char *line, size_t length, const char *text)
+{
+    while (*text != '\0')
+        line[length++] = *text++;
+    return length;
+}
+
+void aoc_progress_write(const aoc_progress_t *progress, int fd)
+{
+    /*
+        Only async-signal-safe functions can be called from a signal handler, because the signal may arrive in
+        the middle of any other function, like malloc() or printf(), whose data may be half updated. Relaxed
+        atomic loads and write() are safe; everything else here is our own code.
+
+        See: https://man7.org/linux/man-pages/man7/signal-safety.7.html
+    */
+    unsigned long long size = atomic_load_explicit(&progress->size, memory_order_relaxed);
+    unsigned long long bytes = atomic_load_explicit(&progress->bytes, memory_order_relaxed);
+    long long sum = atomic_load_explicit(&progress->sum, memory_order_relaxed);
+
+    char line[256];
+    size_t length = append_text(line, 0, "progress     ");
+    length = append_number(line, length, bytes);
+    if (size != 0)
+    {
+        length = append_text(line, length, " of ");
+        length = append_number(line, length, size);
+        length = append_text(line, length, " bytes (");
+        length = append_number(line, length, bytes >= size ? 100 : bytes * 100 / size);
+        length = append_text(line, length, "%)");
+    }
+    else
+        length = append_text(line, length, " bytes");
+    length = append_text(line, length, ", ");
+    length = append_number(line, length, atomic_load_explicit(&progress->lines, memory_order_relaxed));
+    length = append_text(line, length, " lines, sum ");
+    if (sum < 0)
+        line[length++] = '-';
+    length = append_number(line, length, sum < 0 ? 0ull - (unsigned long long)sum : (unsigned long long)sum);
+    length = append_text(line, length, ", ");
+    length = append_number(line, length, atomic_load_explicit(&progress->throughput, memory_order_relaxed) / 1000000);
+    length = append_text(line, length, " MB/s, ");
+    unsigned long long started = atomic_load_explicit(&progress->started, memory_order_relaxed);
+    length = append_number(line, length, (aoc_now_ns() - started) / 1000000000); // clock_gettime() is safe too.
+    length = append_text(line, length, " s");
+    if (atomic_load_explicit(&progress->finished, memory_order_relaxed))
+        length = append_text(line, length, ", finished");
+    line[length++] = '\n';
+#if defined(AOC_HAVE_SHM)
+    (void)!write(fd, line, length); // "(void)!" because glibc insists that we look at write()'s result.
+#else
+    (void)_write(fd, line, (unsigned)length);
+#endif
+}
+
+#if defined(AOC_HAVE_SHM)
+static void dump(int signal)
+{
+    (void)signal;
+    int saved = errno; // write() may change errno, under the feet of whatever code we interrupted.
+    aoc_progress_write(SignalProgress, STDERR_FILENO);
+    errno = saved;
+}
+#endif
+
+void aoc_progress_signal(const aoc_progress_t *progress)
+{
+#if defined(AOC_HAVE_SHM)
+    /*
+        SA_RESTART makes most system calls that the signal interrupts carry on afterwards, rather than
+        fail with EINTR. The ones that can't (like sleeping) are retried by their callers.
+
+        See: https://man7.org/linux/man-pages/man2/sigaction.2.html
+    */
+    SignalProgress = progress;
+    struct sigaction action = {.sa_handler = dump, .sa_flags = SA_RESTART};
+    (void)sigemptyset(&action.sa_mask);
+    (void)sigaction(SIGUSR1, &action, NULL);
+#else
+    (void)progress;
+#endif
+}
+
+const char *aoc_progress_watch(long pid, int fd)
+{
+#if defined(AOC_HAVE_SHM)
+    char name[64];
+    page_name(name, sizeof name, pid);
+    int page = shm_open(name, O_RDONLY, 0);
+    if (page < 0)
+        return "No progress page for that process (run it with --progress)";
+    const aoc_progress_t *progress = mmap(NULL, sizeof *progress, PROT_READ, MAP_SHARED, page, 0);
+    (void)close(page);
+    if (progress == MAP_FAILED)
+        return "Unable to map progress page";
+    if (progress->magic != MAGIC)
+    {
+        (void)munmap((void *)progress, sizeof *progress);
+        return "That isn't a progress page";
+    }
+
+    // Print a line every second, until the run finishes, or the process is gone (kill() with signal 0 only checks).
+    for (;;)
+    {
+        aoc_progress_write(progress, fd);
+        if (atomic_load_explicit(&progress->finished, memory_order_relaxed) || kill((pid_t)pid, 0) != 0)
+            break;
+        struct timespec second = {.tv_sec = 1};
+        (void)nanosleep(&second, NULL);
+    }
+    (void)munmap((void *)progress, sizeof *progress);
+    return NULL;
+#else
+    (void)pid;
+    (void)fd;
+    return "Progress pages aren't supported on this system";
+#endif
+}
@@ -0,0 +1,22 @@
+// This file reads Linux's small settings files, for sysfs.h.
+
+// stdio.h used for fopen() and fgets()
+#include <stdio.h>
+// string.h used for strcspn()
+#include <string.h>
+
+#include "sysfs.h"
+
+bool aoc_read_line(const char *folder, const char *name, char *line, size_t size)
+{
+    char path[AOC_PATH_LENGTH];
+    if (snprintf(path, sizeof path, "%s/%s", folder, name) >= (int)sizeof path)
+        return false;
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        return false;
+    bool ok = fgets(line, (int)size, f) != NULL;
+    (void)fclose(f);
+    line[strcspn(line, "\n")] = '\0';
+    return ok;
+}
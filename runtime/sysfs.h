@@ -0,0 +1,18 @@
+// This file declares what limits.c and topology.c share for reading Linux's small settings files, like the ones
+// in /sys/fs/cgroup and /sys/devices/system/cpu. It's only for the runtime's own files: programs use aoc_runtime.h.
+
+#ifndef AOC_SYSFS_H
+#define AOC_SYSFS_H
+
+// stdbool.h used for the bool type
+#include <stdbool.h>
+// stddef.h used for size_t
+#include <stddef.h>
+
+// Paths are at most this long. Linux's own limit (PATH_MAX) is 4096 too.
+#define AOC_PATH_LENGTH 4096
+
+// Read the first line of 'folder'/'name' into 'line', without its newline. Returns false if there's no such file.
+bool aoc_read_line(const char *folder, const char *name, char *line, size_t size);
+
+#endif // AOC_SYSFS_H
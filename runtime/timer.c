@@ -0,0 +1,73 @@
+// This file implements the phase timers declared in aoc_runtime.h.
+
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L // For clock_gettime(). See input.c.
+#endif
+
+// time.h used for clock_gettime() or timespec_get()
+#include <time.h>
+
+#if defined(_WIN32)
+// windows.h used for QueryPerformanceCounter()
+#include <windows.h>
+#endif
+
+#include "aoc_runtime.h"
+
+unsigned long long aoc_now_ns(void)
+{
+#if defined(_WIN32)
+    /*
+        Windows' most precise clock counts "ticks" at a fixed frequency, which we convert to nanoseconds.
+        Dividing the whole count would overflow sooner, so whole seconds and the remainder are converted separately.
+
+        See: https://learn.microsoft.com/en-us/windows/win32/sysinfo/acquiring-high-resolution-time-stamps
+    */
+    LARGE_INTEGER now, frequency;
+    (void)QueryPerformanceCounter(&now);
+    (void)QueryPerformanceFrequency(&frequency);
+    unsigned long long ticks = (unsigned long long)now.QuadPart, hz = (unsigned long long)frequency.QuadPart;
+    return ticks / hz * 1000000000ULL + ticks % hz * 1000000000ULL / hz;
+#elif defined(CLOCK_MONOTONIC)
+    // See: https://man7.org/linux/man-pages/man3/clock_gettime.3.html
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+#else
+    // Standard C's only clock with nanoseconds. It's the time of day, so it isn't monotonic, but it's better than nothing.
+    struct timespec now;
+    (void)timespec_get(&now, TIME_UTC);
+    return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+#endif
+}
+
+void aoc_timer_start(aoc_timer_t *timer)
+{
+    timer->count = 0;
+    timer->start = aoc_now_ns();
+}
+
+void aoc_timer_phase(aoc_timer_t *timer, const char *name)
+{
+    unsigned long long now = aoc_now_ns();
+    if (timer->count < AOC_TIMER_MAX_PHASES)
+    {
+        timer->names[timer->count] = name;
+        timer->nanoseconds[timer->count++] = now - timer->start;
+    }
+    timer->start = now;
+}
+
+void aoc_timer_print(const aoc_timer_t *timer, FILE *out, unsigned long long bytes)
+{
+    unsigned long long total = 0;
+    for (unsigned i = 0; i < timer->count; i++)
+    {
+        (void)fprintf(out, "%-12s %12.3f ms\n", timer->names[i], (double)timer->nanoseconds[i] / 1e6);
+        total += timer->nanoseconds[i];
+    }
+    (void)fprintf(out, "%-12s %12.3f ms\n", "total", (double)total / 1e6);
+    if (bytes != 0 && total != 0)
+        // Bytes per nanosecond is the same number as gigabytes (10^9 bytes) per second.
+        (void)fprintf(out, "%-12s %12.3f GB/s (%llu bytes)\n", "throughput", (double)bytes / (double)total, bytes);
+}
@@ -0,0 +1,225 @@
+// This file decides which CPUs threads should run on, for aoc_placement_read() and aoc_pin() in aoc_runtime.h.
+
+// See limits.c: _GNU_SOURCE is for sched_setaffinity() and the CPU_SET() macros.
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+// stdio.h used for reading the topology files, and printing
+#include <stdio.h>
+// stdlib.h used for getenv(), strtoul() and qsort()
+#include <stdlib.h>
+// string.h used for strcmp()
+#include <string.h>
+
+#if defined(__linux__)
+// sched.h used for sched_getaffinity() and sched_setaffinity()
+#include <sched.h>
+#endif
+
+#include "aoc_runtime.h"
+#include "sysfs.h"
+
+const char *aoc_placement_parse(aoc_placement_t *placement, const char *list)
+{
+    bool listed[AOC_MAX_CPUS] = {false};
+    *placement = (aoc_placement_t){0};
+    while (*list != '\0')
+    {
+        // strtoul() would skip spaces and accept a '-' sign, so check for a digit first.
+        if (*list < '0' || *list > '9')
+            return "Expected a CPU number";
+        char *end;
+        unsigned long first = strtoul(list, &end, 10), last = first;
+        if (*end == '-')
+        {
+            list = end + 1;
+            if (*list < '0' || *list > '9')
+                return "Expected a CPU number";
+            last = strtoul(list, &end, 10);
+        }
+        if (last < first)
+            return "CPU range is backwards";
+        if (last >= AOC_MAX_CPUS)
+            return "CPU number is too big";
+        for (unsigned long cpu = first; cpu <= last; cpu++)
+        {
+            if (listed[cpu])
+                return "CPU is listed twice";
+            listed[cpu] = true;
+            placement->cpus[placement->count++] = (unsigned)cpu;
+        }
+        if (*end != ',' && *end != '\0')
+            return "Expected ',' between CPUs";
+        list = *end == ',' ? end + 1 : end;
+    }
+    if (placement->count == 0)
+        return "No CPUs listed";
+    placement->shared = placement->count; // We don't know which of them share a cache, so the reader may use any.
+    return NULL;
+}
+
+#if defined(__linux__)
+// Read a CPU list from 'folder'/'name', and return the first CPU in it, or 'otherwise' if there's no such file.
+static unsigned read_first_cpu(const char *folder, const char *name, unsigned otherwise)
+{
+    char line[AOC_PATH_LENGTH];
+    aoc_placement_t list;
+    if (!aoc_read_line(folder, name, line, sizeof line) || aoc_placement_parse(&list, line) != NULL)
+        return otherwise;
+    return list.cpus[0];
+}
+
+// What we know about one CPU, for sorting them into the order we'd like to use them in.
+typedef struct AOC_CPU
+{
+    unsigned cpu;
+    unsigned cache;      // The first CPU that shares its L3 cache, which names the cache.
+    unsigned cacheCores; // How many physical cores share that L3 cache.
+    unsigned sibling;    // 0 for the first "hyperthread" of its core that we may use, 1 for the next...
+} aoc_cpu_t;
+
+/*
+    Caches with more cores come first (they can take more workers without leaving the cache), then the
+    first "hyperthread" of each core in the cache, then the second of each one...
+*/
+static int compare_cpus(const void *left, const void *right)
+{
+    const aoc_cpu_t *a = left, *b = right;
+    if (a->cacheCores != b->cacheCores)
+        return a->cacheCores > b->cacheCores ? -1 : 1;
+    if (a->cache != b->cache)
+        return a->cache < b->cache ? -1 : 1;
+    if (a->sibling != b->sibling)
+        return a->sibling < b->sibling ? -1 : 1;
+    return a->cpu < b->cpu ? -1 : a->cpu > b->cpu;
+}
+#endif
+
+void aoc_placement_read(aoc_placement_t *placement)
+{
+    *placement = (aoc_placement_t){0};
+#if defined(__linux__)
+    /*
+        The CPUs we may use are the ones that are switched on ("online"), and in our affinity mask (see
+        aoc_limits_read()). The environment variable AOC_SYSFS_CPU can name a folder to read instead of
+        /sys/devices/system/cpu, which is handy for testing. Its CPUs are made up, so the mask doesn't apply.
+    */
+    const char *folder = getenv("AOC_SYSFS_CPU");
+    bool madeUp = folder != NULL;
+    if (!madeUp)
+        folder = "/sys/devices/system/cpu";
+    char line[AOC_PATH_LENGTH];
+    aoc_placement_t online;
+    if (!aoc_read_line(folder, "online", line, sizeof line) || aoc_placement_parse(&online, line) != NULL)
+        return;
+    cpu_set_t mask;
+    if (!madeUp && sched_getaffinity(0, sizeof mask, &mask) != 0)
+        return;
+
+    aoc_cpu_t cpus[AOC_MAX_CPUS];
+    unsigned count = 0, core[AOC_MAX_CPUS];
+    for (unsigned i = 0; i < online.count; i++)
+    {
+        unsigned cpu = online.cpus[i];
+        if (!madeUp && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &mask)))
+            continue;
+
+        /*
+            "Hyperthreads" (SMT) on the same physical core share its L1 and L2 caches, and take turns using
+            the same execution units. The core is named by the first CPU in thread_siblings_list.
+            cache/indexN describes each of the CPU's caches, and we want the one with level 3: the biggest,
+            shared by several cores. Without those files (in some virtual machines), every CPU gets a core
+            of its own, and they all share one cache.
+
+            See: https://docs.kernel.org/admin-guide/abi-stable.html (search for "topology")
+            See: https://en.wikipedia.org/wiki/Simultaneous_multithreading
+        */
+        char name[64];
+        (void)snprintf(name, sizeof name, "cpu%u/topology/thread_siblings_list", cpu);
+        core[count] = read_first_cpu(folder, name, cpu);
+        cpus[count] = (aoc_cpu_t){.cpu = cpu, .cache = 0};
+        for (unsigned index = 0; index < 16; index++)
+        {
+            (void)snprintf(name, sizeof name, "cpu%u/cache/index%u/level", cpu, index);
+            if (aoc_read_line(folder, name, line, sizeof line) && strcmp(line, "3") == 0)
+            {
+                (void)snprintf(name, sizeof name, "cpu%u/cache/index%u/shared_cpu_list", cpu, index);
+                cpus[count].cache = read_first_cpu(folder, name, 0);
+                break;
+            }
+        }
+        count++;
+    }
+
+    // Number each core's hyperthreads, and count the cores and caches. Quadratic, but only for a thousand CPUs at most.
+    for (unsigned i = 0; i < count; i++)
+    {
+        bool newCache = true;
+        for (unsigned j = 0; j < i; j++)
+        {
+            cpus[i].sibling += core[j] == core[i];
+            newCache = newCache && cpus[j].cache != cpus[i].cache;
+        }
+        placement->cores += cpus[i].sibling == 0;
+        placement->caches += newCache;
+    }
+    for (unsigned i = 0; i < count; i++)
+        for (unsigned j = 0; j < count; j++)
+            cpus[i].cacheCores += cpus[j].cache == cpus[i].cache && cpus[j].sibling == 0;
+
+    qsort(cpus, count, sizeof *cpus, compare_cpus);
+    for (unsigned i = 0; i < count; i++)
+    {
+        placement->cpus[i] = cpus[i].cpu;
+        placement->shared += cpus[i].cache == cpus[0].cache;
+    }
+    placement->count = count;
+#endif
+}
+
+bool aoc_pin(const unsigned *cpus, unsigned count, aoc_placement_t *previous)
+{
+#if defined(__linux__)
+    /*
+        sched_setaffinity() with a process ID of 0 changes the thread that calls it (on Linux, every thread
+        has an ID of its own, and 0 means "me"), so each thread pins itself.
+
+        See: https://man7.org/linux/man-pages/man2/sched_setaffinity.2.html
+    */
+    cpu_set_t mask;
+    if (previous != NULL)
+    {
+        *previous = (aoc_placement_t){0};
+        if (sched_getaffinity(0, sizeof mask, &mask) == 0)
+            for (unsigned cpu = 0; cpu < CPU_SETSIZE && cpu < AOC_MAX_CPUS; cpu++)
+                if (CPU_ISSET(cpu, &mask))
+                    previous->cpus[previous->count++] = cpu;
+        previous->shared = previous->count;
+    }
+    CPU_ZERO(&mask);
+    for (unsigned i = 0; i < count; i++)
+        if (cpus[i] < CPU_SETSIZE)
+            CPU_SET(cpus[i], &mask);
+    return count > 0 && sched_setaffinity(0, sizeof mask, &mask) == 0;
+#else
+    (void)cpus;
+    (void)count;
+    if (previous != NULL)
+        *previous = (aoc_placement_t){0};
+    return false;
+#endif
+}
+
+void aoc_placement_print(const aoc_placement_t *placement, FILE *out)
+{
+    (void)fprintf(out, "%-12s", "placement");
+    if (placement->count == 0)
+        (void)fprintf(out, " anywhere");
+    for (unsigned i = 0; i < placement->count; i++)
+        (void)fprintf(out, " %u", placement->cpus[i]);
+    if (placement->cores != 0)
+        (void)fprintf(out, " (%u cores, %u L3 caches, reader on the first %u)", placement->cores, placement->caches,
+                      placement->shared);
+    (void)fprintf(out, "\n");
+}